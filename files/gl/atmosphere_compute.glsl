@@ -0,0 +1,32 @@
+#version 310 es
+
+#if defined(COMPILING_CS)
+
+    precision highp float;
+
+    // Sizes are chosen at link time by ComputePipeline::SelectWorkgroupSize
+    layout(local_size_x = WORKGROUP_SIZE_X, local_size_y = WORKGROUP_SIZE_Y) in;
+
+    layout(rgba32f, binding = 0) writeonly uniform highp image2D atmosphere_image;
+
+    #include "scattering.glsl"
+
+    void main() {
+        ivec2 size = imageSize(atmosphere_image);
+        ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+
+        // The dispatch is rounded up to whole workgroups
+        if (texel.x >= size.x || texel.y >= size.y) {
+            return;
+        }
+
+        // Texel centres, matching the fragment pass v_texcoord
+        vec2 coords = (vec2(texel) + 0.5) / vec2(size);
+
+        imageStore(
+            atmosphere_image,
+            texel,
+            vec4(atmosphere_color(coords), 1.0));
+    }
+
+#endif
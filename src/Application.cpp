@@ -1,8 +1,12 @@
 #include "Application.hpp"
 
+#include "Pack.hpp"
+#include "Snapshot.hpp"
 #include "Input.hpp"
 #include "imgui/imgui.h"
 #include "math/Random.hpp"
+#include "gl/State.hpp"
+#include "gl/ProgramCache.hpp"
 
 #include <array>
 
@@ -12,8 +16,19 @@
 #include "sdl/MainWeb.hpp"
 #endif
 
+const std::string snapshot_path = "cache/snapshot.bin";
+
+const float day_length_seconds = 60.0f;
+const size_t day_cycle_table_size = 256;
+
 int main(int argc, char* argv[])
 {
+    // Every asset from one mapping when the build packed files/
+    Pack::Mount("files.pack");
+
+    // State derived on the last clean run, missing records are rebuilt
+    Snapshot::Load(snapshot_path);
+
     std::unique_ptr<IApplication> app = std::make_unique<Application>();
     return sdl_init(app);
 }
@@ -26,16 +41,38 @@ void Application::Init()
     camera = std::make_unique<Camera>();
     camera->position = glm::vec3(0, 0, 0);
 
-    pipeline.Init();
+    pipeline.Init(
+        context->asset_loader);
 
     gui.Init();
 
+    const auto& cache_stats = GL::ProgramCache::Stats();
+
+    std::cout << "Program cache: " <<
+        cache_stats.hits << " hits, " <<
+        cache_stats.misses << " misses (" <<
+        cache_stats.rejected << " rejected), " <<
+        cache_stats.link_ms << " ms linking" << std::endl;
+
     pipeline.InitAtmosphere(
         framebuffer_width,
         framebuffer_height);
 
+    auto& uniforms = pipeline.uniforms();
+
+    sun_elevation.Bind(
+        uniforms->object.elevation_uniform,
+        uniforms->Dirty());
+
     fps_time = timer_start();
 
+#if !defined(EMSCRIPTEN)
+    shader_watcher = std::make_unique<FileWatcher>(
+        "files/gl/");
+#endif
+
+    InitDayCycle();
+
     prop.Animate(
         context->property_manager,
         0, 1.0f, 1.0f,
@@ -51,6 +88,8 @@ void Application::Deinit()
     pipeline.DeinitAtmosphere();
     pipeline.Deinit();
     gui.Deinit();
+
+    Snapshot::Save(snapshot_path);
 }
 
 void Application::Update()
@@ -59,14 +98,39 @@ void Application::Update()
     fps_time = timer_start();
     fps_time_avg = fps_alpha * fps_time_avg + (1.0f - fps_alpha) * time_ms;
 
+    GL::State::NewFrame();
+
+    // Uploads for assets that finished loading since the last frame
+    context->asset_loader.Poll();
+
     const float fps_scale = std::max<float>(
         1.0f / std::min<float>(5.0f, fps_time_avg / 16.66666f), 0.1f);
 
     context->property_manager.Update(
         time_ms / 1000.0f);
 
+    if (day_cycle)
+    {
+        UpdateDayCycle(
+            time_ms / 1000.0f);
+    }
+
     const bool reinit_pipeline = GuiUpdate();
 
+    if (shader_watcher != nullptr)
+    {
+        const auto changed_files = shader_watcher->Poll();
+
+        // The packed copies of edited files are stale
+        for (const auto& file : changed_files)
+        {
+            Pack::Override(file);
+        }
+
+        pipeline.ReloadShaders(
+            changed_files);
+    }
+
     const float window_aspect_ratio =
         static_cast<float>(window_width) /
         window_height;
@@ -108,6 +172,71 @@ void Application::Update()
     gui.Draw(
         window_width,
         window_height);
+
+    // The GUI renderer issues some GL calls directly, so the shadowed
+    // bindings are not trusted past it
+    GL::State::Invalidate();
+}
+
+void Application::InitDayCycle()
+{
+    const float dawn = 0.0f;
+    const float morning = day_length_seconds * 0.25f;
+    const float noon = day_length_seconds * 0.5f;
+    const float evening = day_length_seconds * 0.75f;
+    const float dusk = day_length_seconds;
+
+    elevation_track.Add(dawn, 0.02f);
+    elevation_track.Add(morning, 0.6f);
+    elevation_track.Add(noon, 1.0f);
+    elevation_track.Add(evening, 0.6f);
+    elevation_track.Add(dusk, 0.02f);
+
+    rayleigh_brightness_track.Add(dawn, 24.0f);
+    rayleigh_brightness_track.Add(noon, 64.0f);
+    rayleigh_brightness_track.Add(dusk, 24.0f);
+
+    mie_brightness_track.Add(dawn, 600.0f);
+    mie_brightness_track.Add(noon, 200.0f);
+    mie_brightness_track.Add(dusk, 600.0f);
+
+    spot_brightness_track.Add(dawn, 4.0f);
+    spot_brightness_track.Add(noon, 10.0f);
+    spot_brightness_track.Add(dusk, 4.0f);
+
+    const glm::vec3 low_sun_kr(0.32f, 0.46f, 0.58f);
+
+    kr_track.Add(dawn, low_sun_kr);
+    kr_track.Add(noon, glm::vec3(Kr[0], Kr[1], Kr[2]));
+    kr_track.Add(dusk, low_sun_kr);
+
+    elevation_track.Bake(day_cycle_table_size);
+    rayleigh_brightness_track.Bake(day_cycle_table_size);
+    mie_brightness_track.Bake(day_cycle_table_size);
+    spot_brightness_track.Bake(day_cycle_table_size);
+    kr_track.Bake(day_cycle_table_size);
+}
+
+void Application::UpdateDayCycle(
+    const float time_step)
+{
+    day_time = std::fmod(
+        day_time + time_step,
+        day_length_seconds);
+
+    auto& uniforms = pipeline.uniforms();
+    auto& object = uniforms->object;
+
+    uniforms->Set(object.elevation_uniform, elevation_track.Sample(day_time));
+    uniforms->Set(object.rayleigh_brightness_uniform, rayleigh_brightness_track.Sample(day_time));
+    uniforms->Set(object.mie_brightness_uniform, mie_brightness_track.Sample(day_time));
+    uniforms->Set(object.spot_brightness_uniform, spot_brightness_track.Sample(day_time));
+
+    // Through the GUI's copy, which the GUI sets on the uniforms
+    const glm::vec3 kr = kr_track.Sample(day_time);
+    Kr[0] = kr.r;
+    Kr[1] = kr.g;
+    Kr[2] = kr.b;
 }
 
 void Application::ViewScale()
@@ -180,78 +309,129 @@ bool Application::GuiUpdate()
         0,
         3);
 
+    bool low_steps =
+        pipeline.options() & Pipelines::ATMOSPHERE_OPTION_LOW_STEPS;
+
+    if (ImGui::Checkbox("Low Step Count", &low_steps))
+    {
+        pipeline.options() ^= Pipelines::ATMOSPHERE_OPTION_LOW_STEPS;
+    }
+
+    ImGui::Checkbox("Freeze Parameters", &pipeline.freeze());
+
+    ImGui::Checkbox("Compute Shader", &pipeline.compute());
+
+    ImGui::Checkbox("Day Cycle", &day_cycle);
+
+    if (ImGui::Button("Sunrise"))
+    {
+        sun_elevation.Animate(
+            context->property_manager,
+            0.0f, 1.0f, 4.0f,
+            Properties::EasingFunction::EaseInOutCubic);
+    }
+
+    ImGui::Text(
+        "Atmosphere program %s, %s",
+        pipeline.Frozen() ? "frozen" : "generic",
+        pipeline.UsingCompute() ? "compute" : "fragment");
+
     auto& uniforms = pipeline.uniforms();
 
-    ImGui::SliderFloat(
+    // Sliders write into the staging copy, which only uploads once marked
+    bool edited = false;
+
+    edited |= ImGui::SliderFloat(
         "Spot Elevatiom",
         &uniforms->object.elevation_uniform,
         0.0,
         1);
 
-    ImGui::SliderFloat(
+    edited |= ImGui::SliderFloat(
         "Rayleigh Brightness",
         &uniforms->object.rayleigh_brightness_uniform,
         1,
         100);
 
-    ImGui::SliderFloat(
+    edited |= ImGui::SliderFloat(
         "Mie Brightness",
         &uniforms->object.mie_brightness_uniform,
         1,
         1000);
 
-    ImGui::SliderFloat(
+    edited |= ImGui::SliderFloat(
         "Spot Brightness",
         &uniforms->object.spot_brightness_uniform,
         1,
         100);
 
-    ImGui::SliderFloat(
+    edited |= ImGui::SliderFloat(
         "Scatter Strength",
         &uniforms->object.scatter_strength_uniform,
         1,
         1000);
 
-    ImGui::SliderFloat(
+    edited |= ImGui::SliderFloat(
         "Rayleigh Strength",
         &uniforms->object.rayleigh_strength_uniform,
         1,
         1000);
 
-    ImGui::SliderFloat(
+    edited |= ImGui::SliderFloat(
         "Mie Strength",
         &uniforms->object.mie_strength_uniform,
         1,
         10000);
 
-    ImGui::SliderFloat(
+    edited |= ImGui::SliderFloat(
         "Rayleigh Collection Power",
         &uniforms->object.rayleigh_collection_power_uniform,
         1,
         100);
 
-    ImGui::SliderFloat(
+    edited |= ImGui::SliderFloat(
         "Mie Collection Power",
         &uniforms->object.mie_collection_power_uniform,
         1,
         100);
 
-    ImGui::SliderFloat(
+    edited |= ImGui::SliderFloat(
         "mie_Distribution",
         &uniforms->object.mie_distribution_uniform,
         1,
         100);
 
+    if (edited)
+    {
+        uniforms->MarkDirty();
+    }
+
     ImGui::ColorEdit3("Kr", Kr);
-    uniforms->object.kr.r = Kr[0];
-    uniforms->object.kr.g = Kr[1];
-    uniforms->object.kr.b = Kr[2];
+
+    uniforms->Set(
+        uniforms->object.kr,
+        glm::vec4(Kr[0], Kr[1], Kr[2], uniforms->object.kr.a));
 
     ImGui::Text(
         "Application average %.3f ms/frame (%.1f FPS)",
         fps_time_avg,
         1000.0f / fps_time_avg);
 
+    const auto& cache_stats = GL::ProgramCache::Stats();
+
+    ImGui::Text(
+        "Program cache %u hits, %u misses, %.1f ms linking",
+        cache_stats.hits,
+        cache_stats.misses,
+        cache_stats.link_ms);
+
+    const auto& state_counters = GL::State::FrameCounters();
+
+    ImGui::Text(
+        "GL state calls %u issued, %u elided",
+        state_counters.issued,
+        state_counters.elided);
+
     ImGui::End();
 
     bool reinit_pipeline = false;
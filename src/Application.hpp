@@ -4,7 +4,9 @@
 #include "Timing.hpp"
 #include "Camera.hpp"
 #include "Geometry.hpp"
+#include "FileWatcher.hpp"
 
+#include "properties/Track.hpp"
 #include "properties/Property.hpp"
 #include "interfaces/IApplication.hpp"
 #include "pipelines/Atmosphere.hpp"
@@ -40,9 +42,26 @@ private:
 
     Properties::Property<float> prop;
 
+    // Bound to the atmosphere uniforms' elevation, "Sunrise" animates it
+    Properties::Property<float> sun_elevation;
+
+    // Looping day/night cycle over the atmosphere parameters
+    bool day_cycle = false;
+    float day_time = 0.0f;
+
+    Properties::Track<float> elevation_track { true };
+    Properties::Track<float> rayleigh_brightness_track { true };
+    Properties::Track<float> mie_brightness_track { true };
+    Properties::Track<float> spot_brightness_track { true };
+    Properties::Track<glm::vec3> kr_track { true };
+
     std::unique_ptr<Camera> camera;
 
+    std::unique_ptr<FileWatcher> shader_watcher;
+
     void ViewScale();
+    void InitDayCycle();
+    void UpdateDayCycle(const float time_step);
     bool GuiUpdate();
 
 public:
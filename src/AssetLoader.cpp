@@ -0,0 +1,321 @@
+#include "AssetLoader.hpp"
+
+#include "File.hpp"
+
+#include <iostream>
+#include <algorithm>
+
+// Touching one byte per page faults the whole file into the page cache
+constexpr size_t prefetch_stride = 4096;
+
+AssetLoader::AssetLoader(const uint32_t worker_count)
+{
+#if !defined(EMSCRIPTEN)
+    // Decoding is CPU bound, images decode in parallel up to the core count
+    const uint32_t count = worker_count > 0 ?
+        worker_count :
+        std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        workers.emplace_back(
+            [this]() {
+                WorkerLoop();
+            });
+    }
+#endif
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        stopping = true;
+        immediate.clear();
+        prefetch.clear();
+    }
+
+    work_available.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void AssetLoader::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!stopping)
+    {
+        if (!RunNext(lock))
+        {
+            work_available.wait(lock);
+        }
+    }
+}
+
+bool AssetLoader::RunNext(
+    std::unique_lock<std::mutex>& lock)
+{
+    std::deque<Job>& queue = immediate.empty() ?
+        prefetch :
+        immediate;
+
+    if (queue.empty())
+    {
+        return false;
+    }
+
+    Job job = std::move(queue.front());
+    queue.pop_front();
+
+    lock.unlock();
+
+    Completion completion = {
+        job.handle,
+        {},
+        nullptr,
+        std::move(job.done)
+    };
+
+    try
+    {
+        completion.result = job.work();
+    }
+    catch (...)
+    {
+        completion.error = std::current_exception();
+    }
+
+    lock.lock();
+
+    outstanding.erase(job.handle);
+
+    if (completion.done != nullptr && cancelled.count(job.handle) == 0)
+    {
+        completed.push_back(std::move(completion));
+    }
+    else
+    {
+        cancelled.erase(job.handle);
+    }
+
+    work_finished.notify_all();
+
+    return true;
+}
+
+LoadHandle AssetLoader::Submit(
+    std::function<std::any()> work,
+    std::function<void(std::any&)> done,
+    const LoadPriority priority)
+{
+    LoadHandle handle = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        handle = next_handle++;
+        outstanding.insert(handle);
+
+        std::deque<Job>& queue = priority == LoadPriority::IMMEDIATE ?
+            immediate :
+            prefetch;
+
+        queue.push_back({
+            handle,
+            std::move(work),
+            std::move(done)
+        });
+    }
+
+    work_available.notify_one();
+
+    return handle;
+}
+
+LoadHandle AssetLoader::Read(
+    const std::string& path,
+    std::function<void(std::vector<uint8_t>&)> done,
+    const LoadPriority priority)
+{
+    return Request<std::vector<uint8_t>>(
+        [path]() {
+            const MappedFile file(path);
+
+            return std::vector<uint8_t>(
+                file.Data(),
+                file.Data() + file.Length());
+        },
+        done,
+        priority);
+}
+
+void AssetLoader::Prefetch(
+    const std::string& path)
+{
+    Submit(
+        [path]() {
+            const MappedFile file(path);
+
+            volatile uint8_t sum = 0;
+
+            for (size_t i = 0; i < file.Length(); i += prefetch_stride)
+            {
+                sum += file.Data()[i];
+            }
+
+            return std::any();
+        },
+        nullptr,
+        LoadPriority::PREFETCH);
+}
+
+void AssetLoader::Cancel(
+    const LoadHandle handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const auto Matches = [handle](const auto& entry) {
+        return entry.handle == handle;
+    };
+
+    for (std::deque<Job>* queue : { &immediate, &prefetch })
+    {
+        const auto it = std::remove_if(
+            queue->begin(),
+            queue->end(),
+            Matches);
+
+        if (it != queue->end())
+        {
+            queue->erase(it, queue->end());
+            outstanding.erase(handle);
+        }
+    }
+
+    completed.erase(
+        std::remove_if(
+            completed.begin(),
+            completed.end(),
+            Matches),
+        completed.end());
+
+    // Still running, RunNext drops the result
+    if (outstanding.count(handle) > 0)
+    {
+        cancelled.insert(handle);
+    }
+}
+
+bool AssetLoader::Pending(
+    const LoadHandle handle)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (cancelled.count(handle) > 0)
+    {
+        return false;
+    }
+
+    return
+        outstanding.count(handle) > 0 ||
+        std::any_of(
+            completed.begin(),
+            completed.end(),
+            [handle](const Completion& completion) {
+                return completion.handle == handle;
+            });
+}
+
+void AssetLoader::Poll()
+{
+    std::vector<Completion> ready;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (workers.empty())
+        {
+            // Everything needed up front, then one streamed job a frame
+            while (!immediate.empty())
+            {
+                RunNext(lock);
+            }
+
+            RunNext(lock);
+        }
+
+        ready.swap(completed);
+    }
+
+    std::exception_ptr done_error = nullptr;
+
+    for (auto& completion : ready)
+    {
+        if (completion.error != nullptr)
+        {
+            try
+            {
+                std::rethrow_exception(completion.error);
+            }
+            catch (const std::exception& e)
+            {
+                std::cout << "Load failed: " << e.what() << std::endl;
+            }
+            catch (...)
+            {
+                std::cout << "Load failed" << std::endl;
+            }
+            continue;
+        }
+
+        // Every completion runs before a throwing one is reported, later
+        // ones may own mapped buffers that only their callback releases
+        try
+        {
+            completion.done(
+                completion.result);
+        }
+        catch (...)
+        {
+            if (done_error == nullptr)
+            {
+                done_error = std::current_exception();
+            }
+        }
+    }
+
+    if (done_error != nullptr)
+    {
+        std::rethrow_exception(done_error);
+    }
+}
+
+void AssetLoader::Wait(
+    const LoadHandle handle)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (outstanding.count(handle) > 0)
+        {
+            if (workers.empty())
+            {
+                if (!RunNext(lock))
+                {
+                    break;
+                }
+            }
+            else
+            {
+                work_finished.wait(lock);
+            }
+        }
+    }
+
+    Poll();
+}
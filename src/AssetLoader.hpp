@@ -0,0 +1,165 @@
+#pragma once
+
+#include <any>
+#include <set>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+enum class LoadPriority
+{
+    // Needed before the first frame, runs ahead of everything else
+    IMMEDIATE,
+    // Streams in once the immediate work is done
+    PREFETCH
+};
+
+using LoadHandle = uint64_t;
+
+// Runs loading work on a small pool of worker threads and hands results
+// back on the main thread, where GL uploads are allowed. Completions are
+// delivered by Poll in the order the work finished. The web build has no
+// workers, there Poll runs the queued work itself.
+class AssetLoader
+{
+private:
+    struct Job
+    {
+        LoadHandle handle;
+        std::function<std::any()> work;
+        std::function<void(std::any&)> done;
+    };
+
+    struct Completion
+    {
+        LoadHandle handle;
+        std::any result;
+        std::exception_ptr error;
+        std::function<void(std::any&)> done;
+    };
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_finished;
+
+    std::deque<Job> immediate;
+    std::deque<Job> prefetch;
+    std::vector<Completion> completed;
+
+    // Queued or running
+    std::set<LoadHandle> outstanding;
+    std::set<LoadHandle> cancelled;
+
+    std::vector<std::thread> workers;
+
+    LoadHandle next_handle = 1;
+    bool stopping = false;
+
+    void WorkerLoop();
+
+    // Runs the next queued job, false when there is none
+    bool RunNext(
+        std::unique_lock<std::mutex>& lock);
+
+    LoadHandle Submit(
+        std::function<std::any()> work,
+        std::function<void(std::any&)> done,
+        const LoadPriority priority);
+
+public:
+    // 0 uses one worker per core besides the main thread
+    AssetLoader(const uint32_t worker_count = 0);
+    AssetLoader(const AssetLoader&) = delete;
+    virtual ~AssetLoader();
+
+    // work runs on a worker thread and must not touch GL, done runs on
+    // the thread calling Poll. T must be copyable.
+    template <typename T>
+    LoadHandle Request(
+        std::function<T()> work,
+        std::function<void(T&)> done,
+        const LoadPriority priority = LoadPriority::IMMEDIATE)
+    {
+        // Moved so the job owns whatever work captured
+        return Submit(
+            [work = std::move(work)]() {
+                return std::any(work());
+            },
+            [done = std::move(done)](std::any& result) {
+                done(*std::any_cast<T>(&result));
+            },
+            priority);
+    }
+
+    // For callers that block on the result themselves, such as a shader
+    // source needed at link. The future is ready once the work finishes,
+    // without a Poll. With no workers the work runs before returning.
+    template <typename T>
+    std::future<T> Async(
+        std::function<T()> work,
+        const LoadPriority priority = LoadPriority::IMMEDIATE)
+    {
+        const auto promise = std::make_shared<std::promise<T>>();
+        std::future<T> future = promise->get_future();
+
+        const auto run = [promise, work]() {
+            try
+            {
+                promise->set_value(work());
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        };
+
+        if (workers.empty())
+        {
+            run();
+            return future;
+        }
+
+        Submit(
+            [run]() {
+                run();
+                return std::any();
+            },
+            nullptr,
+            priority);
+
+        return future;
+    }
+
+    // Whole file contents, through the asset pack or a mapping
+    LoadHandle Read(
+        const std::string& path,
+        std::function<void(std::vector<uint8_t>&)> done,
+        const LoadPriority priority = LoadPriority::IMMEDIATE);
+
+    // Pulls path into the page cache so a later load doesn't wait on disk
+    void Prefetch(
+        const std::string& path);
+
+    // Drops the completion, work that already started still finishes
+    void Cancel(
+        const LoadHandle handle);
+
+    // True until the completion has run or the request was cancelled
+    bool Pending(
+        const LoadHandle handle);
+
+    // Runs completions of finished work, call once per frame
+    void Poll();
+
+    // Blocks until handle finished, then polls
+    void Wait(
+        const LoadHandle handle);
+};
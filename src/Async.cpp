@@ -0,0 +1 @@
+#include "Async.hpp"
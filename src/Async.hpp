@@ -0,0 +1,20 @@
+#pragma once
+
+#include <future>
+#include <utility>
+
+// The web build has no worker threads unless built with pthreads, there
+// the work runs on the main thread when the result is first requested.
+#if defined(EMSCRIPTEN)
+constexpr std::launch async_launch_policy = std::launch::deferred;
+#else
+constexpr std::launch async_launch_policy = std::launch::async;
+#endif
+
+template <typename F>
+auto run_async(F&& function)
+{
+    return std::async(
+        async_launch_policy,
+        std::forward<F>(function));
+}
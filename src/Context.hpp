@@ -1,11 +1,13 @@
 #pragma once
 
+#include "AssetLoader.hpp"
 #include "properties/Manager.hpp"
 
 class Context
 {
 public:
     Properties::Manager property_manager;
+    AssetLoader asset_loader;
 
     Context() = default;
 };
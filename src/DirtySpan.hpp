@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Bytes of a CPU side copy written since it was last uploaded, one range
+// covering every marked field. Writers mark, the owner uploads
+// [begin, end) and clears.
+struct DirtySpan
+{
+    const uint8_t* base = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+
+    bool Empty() const
+    {
+        return begin >= end;
+    }
+
+    void Mark(
+        const void* field,
+        const size_t size)
+    {
+        const size_t offset = static_cast<size_t>(
+            static_cast<const uint8_t*>(field) - base);
+
+        if (Empty())
+        {
+            begin = offset;
+            end = offset + size;
+            return;
+        }
+
+        begin = std::min(begin, offset);
+        end = std::max(end, offset + size);
+    }
+
+    void Clear()
+    {
+        begin = 0;
+        end = 0;
+    }
+};
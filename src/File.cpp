@@ -1,12 +1,82 @@
 #include "File.hpp"
 
+#include <cstring>
 #include <iostream>
+#include <algorithm>
 #include <assert.h>
 
-#if defined(EMSCRIPTEN)
+#if defined(__linux__) && !defined(EMSCRIPTEN)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define FILE_MMAP
+#endif
+
+// Host tools built with FILE_STDIO link neither SDL nor the asset pack
+#if !defined(FILE_STDIO)
+#include "Pack.hpp"
+#endif
+
+bool File::OpenPacked(const std::string& path, const std::string& mode)
+{
+#if !defined(FILE_STDIO)
+    if (mode.empty() || mode[0] != 'r')
+    {
+        return false;
+    }
+
+    const auto contents = Pack::Contents(
+        path,
+        inflated);
+
+    if (!contents.has_value())
+    {
+        return false;
+    }
+
+    packed = reinterpret_cast<const uint8_t*>(contents->data());
+    length = contents->size();
+    position = 0;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t File::ReadPacked(void* buffer, size_t size, size_t count)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    // Whole items only, like fread
+    count = std::min(count, (length - position) / size);
+
+    if (count > 0)
+    {
+        std::memcpy(
+            buffer,
+            packed + position,
+            size * count);
+    }
+
+    position += size * count;
+
+    return count;
+}
+
+#if defined(EMSCRIPTEN) || defined(FILE_STDIO)
 
 File::File(std::string path, std::string mode)
 {
+    if (OpenPacked(path, mode))
+    {
+        return;
+    }
+
     auto h = fopen(path.c_str(), mode.c_str());
 
     if (h == nullptr)
@@ -24,14 +94,34 @@ File::File(std::string path, std::string mode)
 
 File::~File()
 {
+    if (!handle.has_value())
+    {
+        return;
+    }
+
     fclose(std::any_cast<FILE*>(handle));
 }
 
 size_t File::Read(void* buffer, size_t size, size_t count)
 {
+    if (packed != nullptr)
+    {
+        return ReadPacked(buffer, size, count);
+    }
+
     return fread(buffer, size, count, std::any_cast<FILE*>(handle));
 }
 
+size_t File::Write(const void* buffer, size_t size, size_t count)
+{
+    if (packed != nullptr)
+    {
+        return 0;
+    }
+
+    return fwrite(buffer, size, count, std::any_cast<FILE*>(handle));
+}
+
 size_t File::Length()
 {
     return length;
@@ -43,6 +133,11 @@ size_t File::Length()
 
 File::File(std::string path, std::string mode)
 {
+    if (OpenPacked(path, mode))
+    {
+        return;
+    }
+
     auto h = SDL_RWFromFile(
         path.c_str(),
         mode.c_str());
@@ -68,16 +163,37 @@ File::File(std::string path, std::string mode)
 
 File::~File()
 {
+    if (!handle.has_value())
+    {
+        return;
+    }
+
     SDL_RWclose(
         std::any_cast<SDL_RWops*>(handle));
 }
 
 size_t File::Read(void* buffer, size_t size, size_t count)
 {
+    if (packed != nullptr)
+    {
+        return ReadPacked(buffer, size, count);
+    }
+
     return SDL_RWread(
         std::any_cast<SDL_RWops*>(handle), buffer, size, count);
 }
 
+size_t File::Write(const void* buffer, size_t size, size_t count)
+{
+    if (packed != nullptr)
+    {
+        return 0;
+    }
+
+    return SDL_RWwrite(
+        std::any_cast<SDL_RWops*>(handle), buffer, size, count);
+}
+
 size_t File::Length()
 {
     return length;
@@ -85,17 +201,15 @@ size_t File::Length()
 
 #endif
 
+// Read straight into the string's storage
 std::string File::ReadString()
 {
-    const auto count = Length();
-    char* buffer = new char[count + 1];
-
-    Read(buffer, sizeof(char), count);
-    buffer[count] = 0x00;
+    std::string str(Length(), '\0');
 
-    std::string str = std::string(buffer);
-
-    delete[] buffer;
+    str.resize(Read(
+        str.data(),
+        sizeof(char),
+        str.size()));
 
     return str;
 }
@@ -103,17 +217,143 @@ std::string File::ReadString()
 // string prefixed with length (uint16_t)
 std::string File::ReadStringPrefixed()
 {
-    uint16_t count;
+    uint16_t count = 0;
     Read(&count, sizeof(uint16_t), 1);
 
-    char* buffer = new char[count + 1];
+    std::string str(count, '\0');
+
+    str.resize(Read(
+        str.data(),
+        sizeof(char),
+        str.size()));
+
+    return str;
+}
 
-    Read(buffer, sizeof(char), count);
-    buffer[count] = 0x00;
+void File::WriteStringPrefixed(const std::string& str)
+{
+    assert(str.size() <= UINT16_MAX);
 
-    std::string str = std::string(buffer);
+    const uint16_t count = static_cast<uint16_t>(str.size());
+    Write(&count, sizeof(uint16_t), 1);
+    Write(str.data(), sizeof(char), count);
+}
 
-    delete[] buffer;
+MappedFile::MappedFile(std::string path, FileAccess access)
+{
+#if !defined(FILE_STDIO)
+    // Stored pack entries are already mapped
+    const auto contents = Pack::Contents(
+        path,
+        buffer);
 
-    return str;
+    if (contents.has_value())
+    {
+        data = reinterpret_cast<const uint8_t*>(contents->data());
+        length = contents->size();
+        return;
+    }
+#endif
+
+#if defined(FILE_MMAP)
+    const int descriptor = open(
+        path.c_str(),
+        O_RDONLY | O_CLOEXEC);
+
+    struct stat info = {};
+
+    if (descriptor >= 0 && fstat(descriptor, &info) == 0)
+    {
+        length = static_cast<size_t>(info.st_size);
+
+        // An empty file can't be mapped but needs no data either
+        void* mapping = length > 0 ?
+            mmap(
+                nullptr,
+                length,
+                PROT_READ,
+                MAP_PRIVATE,
+                descriptor,
+                0) :
+            MAP_FAILED;
+
+        if (mapping != MAP_FAILED)
+        {
+            madvise(
+                mapping,
+                length,
+                access == FileAccess::SEQUENTIAL ?
+                    MADV_SEQUENTIAL :
+                    MADV_RANDOM);
+
+            if (access == FileAccess::SEQUENTIAL)
+            {
+                // Start readahead now, the caller is about to walk it all
+                madvise(
+                    mapping,
+                    length,
+                    MADV_WILLNEED);
+            }
+
+            data = static_cast<const uint8_t*>(mapping);
+            mapped = true;
+        }
+    }
+
+    if (descriptor >= 0)
+    {
+        // The mapping keeps its own reference to the file
+        close(descriptor);
+    }
+
+    if (mapped || (descriptor >= 0 && length == 0))
+    {
+        return;
+    }
+#endif
+
+    File file(path, "rb");
+
+    buffer.resize(file.Length());
+    buffer.resize(file.Read(
+        buffer.data(),
+        1,
+        buffer.size()));
+
+    data = buffer.data();
+    length = buffer.size();
+}
+
+MappedFile::~MappedFile()
+{
+#if defined(FILE_MMAP)
+    if (mapped)
+    {
+        munmap(
+            const_cast<uint8_t*>(data),
+            length);
+    }
+#endif
+}
+
+const uint8_t* MappedFile::Data() const
+{
+    return data;
+}
+
+std::string_view MappedFile::View() const
+{
+    return std::string_view(
+        reinterpret_cast<const char*>(data),
+        length);
+}
+
+size_t MappedFile::Length() const
+{
+    return length;
+}
+
+bool MappedFile::Mapped() const
+{
+    return mapped;
 }
@@ -1,6 +1,10 @@
+#pragma once
+
 #include <any>
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <string_view>
 
 class File
 {
@@ -8,14 +12,55 @@ private:
     size_t length;
     std::any handle;
 
+    // Entry served from the mounted pack instead of a handle
+    const uint8_t* packed = nullptr;
+    size_t position = 0;
+    std::vector<uint8_t> inflated;
+
+    bool OpenPacked(const std::string& path, const std::string& mode);
+    size_t ReadPacked(void* buffer, size_t size, size_t count);
+
 public:
     File(std::string path, std::string mode);
     virtual ~File();
 
     size_t Read(void* buffer, size_t size, size_t count);
+    size_t Write(const void* buffer, size_t size, size_t count);
 
     std::string ReadString();
     std::string ReadStringPrefixed();
+    void WriteStringPrefixed(const std::string& str);
 
     size_t Length();
 };
+
+enum class FileAccess
+{
+    SEQUENTIAL,
+    RANDOM
+};
+
+// Read-only view of a whole file. Memory mapped on Linux so contents come
+// straight from the page cache, elsewhere or when mapping fails the file
+// is read once through File into an owned buffer.
+class MappedFile
+{
+private:
+    const uint8_t* data = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+
+    std::vector<uint8_t> buffer;
+
+public:
+    MappedFile(std::string path, FileAccess access = FileAccess::SEQUENTIAL);
+    MappedFile(const MappedFile&) = delete;
+    virtual ~MappedFile();
+
+    // Valid for the lifetime of the MappedFile
+    const uint8_t* Data() const;
+    std::string_view View() const;
+
+    size_t Length() const;
+    bool Mapped() const;
+};
@@ -0,0 +1,126 @@
+#include "FileWatcher.hpp"
+
+#include <set>
+#include <iostream>
+
+#if defined(__linux__) && !defined(EMSCRIPTEN)
+#include <unistd.h>
+#include <sys/inotify.h>
+#define FILE_WATCHER_INOTIFY
+#endif
+
+FileWatcher::FileWatcher(const std::string directory) :
+    directory(directory)
+{
+#if defined(FILE_WATCHER_INOTIFY)
+    inotify_handle = inotify_init1(
+        IN_NONBLOCK | IN_CLOEXEC);
+
+    if (inotify_handle >= 0)
+    {
+        // Editors either rewrite in place or write a temporary and rename
+        watch_handle = inotify_add_watch(
+            inotify_handle,
+            directory.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO);
+    }
+
+    if (watch_handle >= 0)
+    {
+        return;
+    }
+
+    std::cout << "inotify unavailable for " << directory <<
+        ", polling modification times" << std::endl;
+#endif
+
+    PollWriteTimes();
+}
+
+FileWatcher::~FileWatcher()
+{
+#if defined(FILE_WATCHER_INOTIFY)
+    if (inotify_handle >= 0)
+    {
+        close(inotify_handle);
+    }
+#endif
+}
+
+std::vector<std::string> FileWatcher::Poll()
+{
+#if defined(FILE_WATCHER_INOTIFY)
+    if (watch_handle >= 0)
+    {
+        std::set<std::string> changed;
+
+        alignas(inotify_event) char buffer[4096];
+
+        for (;;)
+        {
+            const ssize_t length = read(
+                inotify_handle,
+                buffer,
+                sizeof(buffer));
+
+            if (length <= 0)
+            {
+                break;
+            }
+
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const auto* event = reinterpret_cast<const inotify_event*>(
+                    buffer + offset);
+
+                if (event->len > 0)
+                {
+                    changed.insert(
+                        (std::filesystem::path(directory) /
+                            event->name).generic_string());
+                }
+
+                offset += sizeof(inotify_event) + event->len;
+            }
+        }
+
+        return std::vector<std::string>(
+            changed.begin(),
+            changed.end());
+    }
+#endif
+
+    return PollWriteTimes();
+}
+
+std::vector<std::string> FileWatcher::PollWriteTimes()
+{
+    std::vector<std::string> changed;
+
+#if !defined(EMSCRIPTEN)
+    std::error_code error;
+
+    for (const auto& entry :
+        std::filesystem::directory_iterator(directory, error))
+    {
+        if (!entry.is_regular_file(error))
+        {
+            continue;
+        }
+
+        const std::string path = entry.path().generic_string();
+        const auto write_time = entry.last_write_time(error);
+
+        const auto it = write_times.find(path);
+
+        if (it != write_times.end() && it->second != write_time)
+        {
+            changed.push_back(path);
+        }
+
+        write_times[path] = write_time;
+    }
+#endif
+
+    return changed;
+}
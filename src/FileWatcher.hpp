@@ -0,0 +1,29 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+// Reports files in a directory that were written since the last Poll.
+// Uses inotify on Linux and falls back to comparing modification times.
+class FileWatcher
+{
+private:
+    std::string directory;
+
+    int inotify_handle = -1;
+    int watch_handle = -1;
+
+    std::map<std::string, std::filesystem::file_time_type> write_times;
+
+    std::vector<std::string> PollWriteTimes();
+
+public:
+    FileWatcher(const std::string directory);
+    FileWatcher(const FileWatcher&) = delete;
+    virtual ~FileWatcher();
+
+    // Paths are returned as directory + file name
+    std::vector<std::string> Poll();
+};
@@ -0,0 +1 @@
+#include "Hash.hpp"
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// FNV-1a, usable at compile time for identifiers and at runtime for cache keys
+constexpr uint64_t fnv_offset_basis = 14695981039346656037ull;
+constexpr uint64_t fnv_prime = 1099511628211ull;
+
+constexpr uint64_t hash_fnv1a(
+    const std::string_view data,
+    const uint64_t seed = fnv_offset_basis)
+{
+    uint64_t hash = seed;
+    for (const char c : data)
+    {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= fnv_prime;
+    }
+    return hash;
+}
+
+inline uint64_t hash_fnv1a(
+    const void* data,
+    const size_t size,
+    const uint64_t seed = fnv_offset_basis)
+{
+    return hash_fnv1a(
+        std::string_view(static_cast<const char*>(data), size),
+        seed);
+}
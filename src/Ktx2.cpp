@@ -0,0 +1,269 @@
+#include "Ktx2.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+namespace Ktx2
+{
+    constexpr uint8_t identifier[12] = {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+    };
+
+    BlockSize FormatBlockSize(
+        const Format format)
+    {
+        switch (format)
+        {
+        case R8G8B8A8_UNORM:
+        case R8G8B8A8_SRGB:
+        case B10G11R11_UFLOAT_PACK32:
+        case E5B9G9R9_UFLOAT_PACK32:
+            return { 1, 1, 4 };
+        case R16G16B16A16_SFLOAT:
+            return { 1, 1, 8 };
+        case R32G32B32A32_SFLOAT:
+            return { 1, 1, 16 };
+        case ETC2_R8G8B8_UNORM_BLOCK:
+        case ETC2_R8G8B8_SRGB_BLOCK:
+            return { 4, 4, 8 };
+        case BC6H_UFLOAT_BLOCK:
+        case ETC2_R8G8B8A8_UNORM_BLOCK:
+        case ETC2_R8G8B8A8_SRGB_BLOCK:
+        case ASTC_4x4_UNORM_BLOCK:
+        case ASTC_4x4_SRGB_BLOCK:
+            return { 4, 4, 16 };
+        case ASTC_6x6_UNORM_BLOCK:
+        case ASTC_6x6_SRGB_BLOCK:
+            return { 6, 6, 16 };
+        case ASTC_8x8_UNORM_BLOCK:
+        case ASTC_8x8_SRGB_BLOCK:
+            return { 8, 8, 16 };
+        }
+
+        throw std::runtime_error(
+            "Unsupported KTX2 format " + std::to_string(format));
+    }
+
+    bool IsCompressed(
+        const Format format)
+    {
+        const BlockSize block = FormatBlockSize(
+            format);
+
+        return block.width > 1 || block.height > 1;
+    }
+
+    uint32_t FormatTypeSize(
+        const Format format)
+    {
+        switch (format)
+        {
+        case R8G8B8A8_UNORM:
+        case R8G8B8A8_SRGB:
+            return 1;
+        case R16G16B16A16_SFLOAT:
+            return 2;
+        case R32G32B32A32_SFLOAT:
+        case B10G11R11_UFLOAT_PACK32:
+        case E5B9G9R9_UFLOAT_PACK32:
+            return 4;
+        default:
+            break;
+        }
+
+        // Throws for formats outside Format
+        FormatBlockSize(
+            format);
+
+        return 1;
+    }
+
+    Image Parse(
+        std::string_view file,
+        const std::string& path)
+    {
+        const auto Fail = [&path](const std::string& reason) {
+            return std::runtime_error(
+                "Invalid KTX2 file " + path + ": " + reason);
+        };
+
+        Header header = {};
+
+        if (file.size() < sizeof(Header))
+        {
+            throw Fail("truncated header");
+        }
+
+        std::memcpy(
+            &header,
+            file.data(),
+            sizeof(Header));
+
+        if (std::memcmp(header.identifier, identifier, sizeof(identifier)) != 0)
+        {
+            throw Fail("bad identifier");
+        }
+
+        if (header.supercompression_scheme != 0)
+        {
+            throw Fail("supercompression is not supported");
+        }
+
+        if (header.pixel_depth > 1 || header.face_count != 1)
+        {
+            throw Fail("only 2D textures and arrays are supported");
+        }
+
+        if (header.pixel_width == 0 || header.pixel_height == 0)
+        {
+            throw Fail("empty image");
+        }
+
+        Image image;
+        image.format = static_cast<Format>(header.vk_format);
+        image.width = header.pixel_width;
+        image.height = header.pixel_height;
+        image.layers = header.layer_count;
+        image.generate_mipmaps = header.level_count == 0;
+
+        const BlockSize block = FormatBlockSize(
+            image.format);
+
+        if (image.generate_mipmaps && IsCompressed(image.format))
+        {
+            throw Fail("block compressed files need a stored mip chain");
+        }
+
+        // GLES 3 can't generate mips for RGBA32F (not filterable), RGB9E5
+        // (not renderable) or R11F_G11F_B10F without EXT_color_buffer_float
+        if (image.generate_mipmaps &&
+            (image.format == R32G32B32A32_SFLOAT ||
+            image.format == E5B9G9R9_UFLOAT_PACK32 ||
+            image.format == B10G11R11_UFLOAT_PACK32))
+        {
+            throw Fail("float files need a stored mip chain");
+        }
+
+        uint32_t mip_chain_length = 1;
+
+        for (uint32_t size = std::max(image.width, image.height); size > 1; size /= 2)
+        {
+            mip_chain_length++;
+        }
+
+        if (header.level_count > mip_chain_length)
+        {
+            throw Fail("too many levels");
+        }
+
+        const uint32_t level_count = std::max(header.level_count, 1u);
+        const uint64_t index_size =
+            static_cast<uint64_t>(level_count) * sizeof(LevelIndex);
+
+        if (sizeof(Header) + index_size > file.size())
+        {
+            throw Fail("truncated level index");
+        }
+
+        const uint32_t layers = std::max(image.layers, 1u);
+
+        for (uint32_t i = 0; i < level_count; i++)
+        {
+            LevelIndex index = {};
+
+            std::memcpy(
+                &index,
+                file.data() + sizeof(Header) + i * sizeof(LevelIndex),
+                sizeof(LevelIndex));
+
+            Level level = {
+                std::max(image.width >> i, 1u),
+                std::max(image.height >> i, 1u),
+                index.byte_offset,
+                index.byte_length
+            };
+
+            const uint64_t blocks_x =
+                (level.width + block.width - 1) / block.width;
+            const uint64_t blocks_y =
+                (level.height + block.height - 1) / block.height;
+
+            const uint64_t expected =
+                blocks_x * blocks_y * block.bytes * layers;
+
+            if (level.length != expected ||
+                level.offset > file.size() ||
+                level.length > file.size() - level.offset)
+            {
+                throw Fail("level " + std::to_string(i) + " out of range");
+            }
+
+            image.levels.push_back(level);
+        }
+
+        return image;
+    }
+
+    std::string Write(
+        const Format format,
+        const uint32_t width,
+        const uint32_t height,
+        const std::vector<std::vector<uint8_t>>& levels)
+    {
+        Header header = {};
+
+        std::memcpy(
+            header.identifier,
+            identifier,
+            sizeof(identifier));
+
+        header.vk_format = format;
+        header.type_size = FormatTypeSize(format);
+        header.pixel_width = width;
+        header.pixel_height = height;
+        header.face_count = 1;
+        header.level_count = static_cast<uint32_t>(levels.size());
+
+        // Levels start on a multiple of the block size and of 4
+        const uint64_t alignment = (FormatBlockSize(format).bytes + 3) / 4 * 4;
+
+        std::vector<LevelIndex> index(levels.size());
+
+        uint64_t offset = sizeof(Header) + levels.size() * sizeof(LevelIndex);
+
+        for (size_t i = levels.size(); i-- > 0;)
+        {
+            offset = (offset + alignment - 1) / alignment * alignment;
+
+            index[i] = {
+                offset,
+                levels[i].size(),
+                levels[i].size()
+            };
+
+            offset += levels[i].size();
+        }
+
+        std::string file(
+            reinterpret_cast<const char*>(&header),
+            sizeof(Header));
+
+        file.append(
+            reinterpret_cast<const char*>(index.data()),
+            index.size() * sizeof(LevelIndex));
+
+        for (size_t i = levels.size(); i-- > 0;)
+        {
+            file.resize(
+                index[i].byte_offset,
+                '\0');
+
+            file.append(
+                reinterpret_cast<const char*>(levels[i].data()),
+                levels[i].size());
+        }
+
+        return file;
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+// Reader for the KTX2 container. Only what GPU upload needs is parsed:
+// the Vulkan format, dimensions and the byte range of every mip level.
+// Payloads are left in place, so levels can be handed to GL straight out
+// of a mapped file. Supercompressed files and cube maps are rejected.
+namespace Ktx2
+{
+    // Vulkan format numbers the GL side knows how to upload
+    enum Format : uint32_t
+    {
+        R8G8B8A8_UNORM = 37,
+        R8G8B8A8_SRGB = 43,
+        R16G16B16A16_SFLOAT = 97,
+        R32G32B32A32_SFLOAT = 109,
+        B10G11R11_UFLOAT_PACK32 = 122,
+        E5B9G9R9_UFLOAT_PACK32 = 123,
+        BC6H_UFLOAT_BLOCK = 143,
+        ETC2_R8G8B8_UNORM_BLOCK = 147,
+        ETC2_R8G8B8_SRGB_BLOCK = 148,
+        ETC2_R8G8B8A8_UNORM_BLOCK = 151,
+        ETC2_R8G8B8A8_SRGB_BLOCK = 152,
+        ASTC_4x4_UNORM_BLOCK = 157,
+        ASTC_4x4_SRGB_BLOCK = 158,
+        ASTC_6x6_UNORM_BLOCK = 165,
+        ASTC_6x6_SRGB_BLOCK = 166,
+        ASTC_8x8_UNORM_BLOCK = 171,
+        ASTC_8x8_SRGB_BLOCK = 172
+    };
+
+    struct Header
+    {
+        uint8_t identifier[12];
+        uint32_t vk_format;
+        uint32_t type_size;
+        uint32_t pixel_width;
+        uint32_t pixel_height;
+        uint32_t pixel_depth;
+        uint32_t layer_count;
+        uint32_t face_count;
+        uint32_t level_count;
+        uint32_t supercompression_scheme;
+        uint32_t dfd_byte_offset;
+        uint32_t dfd_byte_length;
+        uint32_t kvd_byte_offset;
+        uint32_t kvd_byte_length;
+        uint64_t sgd_byte_offset;
+        uint64_t sgd_byte_length;
+    };
+
+    struct LevelIndex
+    {
+        uint64_t byte_offset;
+        uint64_t byte_length;
+        uint64_t uncompressed_byte_length;
+    };
+
+    static_assert(sizeof(Header) == 80);
+    static_assert(sizeof(LevelIndex) == 24);
+
+    struct BlockSize
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t bytes;
+    };
+
+    struct Level
+    {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    struct Image
+    {
+        Format format;
+        uint32_t width;
+        uint32_t height;
+
+        // 0 for a plain 2D texture, otherwise the array size
+        uint32_t layers;
+
+        // Largest first, as stored in the level index. A file without a
+        // mip chain has one level and asks for it to be generated, only
+        // allowed for RGBA8 and RGBA16F.
+        std::vector<Level> levels;
+        bool generate_mipmaps;
+    };
+
+    // Block dimensions, 1x1 with the texel size for uncompressed formats.
+    // Throws for formats outside Format.
+    BlockSize FormatBlockSize(
+        const Format format);
+
+    bool IsCompressed(
+        const Format format);
+
+    // The header's typeSize: bytes per component for uncompressed formats,
+    // the whole texel for packed ones and 1 for block compressed ones
+    uint32_t FormatTypeSize(
+        const Format format);
+
+    // Validates every level range against the file, throws with path in
+    // the message when anything is out of bounds or unsupported
+    Image Parse(
+        std::string_view file,
+        const std::string& path);
+
+    // Serialises levels, largest first, into a file Parse accepts. Level
+    // data is stored smallest first so a streamed read finds the coarse
+    // levels at the front. No data format descriptor is written, which the
+    // KTX2 spec requires, so the files are for this app's Parse only and
+    // general KTX tools reject them.
+    std::string Write(
+        const Format format,
+        const uint32_t width,
+        const uint32_t height,
+        const std::vector<std::vector<uint8_t>>& levels);
+}
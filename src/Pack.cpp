@@ -0,0 +1,219 @@
+#include "Pack.hpp"
+
+#include "File.hpp"
+#include "Hash.hpp"
+
+#include <set>
+#include <mutex>
+#include <memory>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+#include "stb/stb_image.h"
+
+namespace Pack
+{
+    static std::unique_ptr<MappedFile> pack;
+    static const Entry* entries = nullptr;
+    static uint32_t entry_count = 0;
+    static const char* names = nullptr;
+
+    static std::mutex override_mutex;
+    static std::set<std::string> overrides;
+
+    std::string NormalPath(
+        const std::string& path)
+    {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    bool Mount(
+        const std::string& pack_path)
+    {
+        Unmount();
+
+        std::error_code error;
+
+        if (!std::filesystem::exists(pack_path, error))
+        {
+            return false;
+        }
+
+        auto file = std::make_unique<MappedFile>(
+            pack_path,
+            FileAccess::RANDOM);
+
+        Header header = {};
+
+        if (file->Length() >= sizeof(Header))
+        {
+            std::memcpy(
+                &header,
+                file->Data(),
+                sizeof(Header));
+        }
+
+        const uint64_t length = file->Length();
+
+        const uint64_t toc_size =
+            static_cast<uint64_t>(header.entry_count) * sizeof(Entry);
+
+        // Written as differences so offsets near 2^64 can't wrap
+        const bool valid =
+            length >= sizeof(Header) &&
+            header.magic == pack_magic &&
+            header.version == pack_version &&
+            header.toc_offset % alignof(Entry) == 0 &&
+            header.toc_offset <= length &&
+            toc_size <= length - header.toc_offset &&
+            header.names_offset <= length &&
+            header.names_size <= length - header.names_offset;
+
+        if (!valid)
+        {
+            std::cout << "Ignoring malformed pack " << pack_path << std::endl;
+            return false;
+        }
+
+        entries = reinterpret_cast<const Entry*>(
+            file->Data() + header.toc_offset);
+
+        for (uint32_t i = 0; i < header.entry_count; i++)
+        {
+            const Entry& entry = entries[i];
+
+            // Contents returns stored entries as a view of size bytes
+            const bool entry_valid =
+                entry.offset <= length &&
+                entry.stored_size <= length - entry.offset &&
+                ((entry.flags & ENTRY_DEFLATE) || entry.size == entry.stored_size) &&
+                static_cast<uint64_t>(entry.name_offset) +
+                    entry.name_length <= header.names_size;
+
+            if (!entry_valid)
+            {
+                std::cout << "Ignoring malformed pack " << pack_path << std::endl;
+                entries = nullptr;
+                return false;
+            }
+        }
+
+        entry_count = header.entry_count;
+        names = reinterpret_cast<const char*>(
+            file->Data() + header.names_offset);
+
+        pack = std::move(file);
+
+        return true;
+    }
+
+    void Unmount()
+    {
+        pack.reset();
+        entries = nullptr;
+        entry_count = 0;
+        names = nullptr;
+
+        std::lock_guard<std::mutex> lock(override_mutex);
+        overrides.clear();
+    }
+
+    const Entry* Find(
+        const std::string& path)
+    {
+        const uint64_t hash = hash_fnv1a(
+            path);
+
+        const Entry* end = entries + entry_count;
+
+        const Entry* entry = std::lower_bound(
+            entries,
+            end,
+            hash,
+            [](const Entry& entry, const uint64_t hash) {
+                return entry.hash < hash;
+            });
+
+        // Names are kept to rule out hash collisions
+        for (; entry != end && entry->hash == hash; entry++)
+        {
+            const std::string_view name(
+                names + entry->name_offset,
+                entry->name_length);
+
+            if (name == path)
+            {
+                return entry;
+            }
+        }
+
+        return nullptr;
+    }
+
+    std::optional<std::string_view> Contents(
+        const std::string& path,
+        std::vector<uint8_t>& storage)
+    {
+        if (pack == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        const std::string normal_path = NormalPath(
+            path);
+
+        {
+            std::lock_guard<std::mutex> lock(override_mutex);
+
+            if (overrides.count(normal_path) > 0)
+            {
+                return std::nullopt;
+            }
+        }
+
+        const Entry* entry = Find(
+            normal_path);
+
+        if (entry == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        const char* blob = reinterpret_cast<const char*>(
+            pack->Data() + entry->offset);
+
+        if (!(entry->flags & ENTRY_DEFLATE))
+        {
+            return std::string_view(
+                blob,
+                entry->size);
+        }
+
+        storage.resize(entry->size);
+
+        const int inflated = stbi_zlib_decode_buffer(
+            reinterpret_cast<char*>(storage.data()),
+            static_cast<int>(storage.size()),
+            blob,
+            static_cast<int>(entry->stored_size));
+
+        if (inflated != static_cast<int>(entry->size))
+        {
+            throw std::runtime_error(
+                "Corrupt pack entry: " + normal_path);
+        }
+
+        return std::string_view(
+            reinterpret_cast<const char*>(storage.data()),
+            storage.size());
+    }
+
+    void Override(
+        const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(override_mutex);
+        overrides.insert(NormalPath(path));
+    }
+}
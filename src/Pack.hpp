@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Read-only archive of the files/ tree, written by tools/AssetPack.cpp.
+// The table of contents is sorted by path hash and every blob starts on a
+// 64 byte boundary, blobs are stored raw or zlib deflated. A mounted pack
+// is mapped once and File and MappedFile serve its entries before looking
+// on disk.
+namespace Pack
+{
+    constexpr uint32_t pack_magic = 0x4B415041; // "APAK"
+    constexpr uint32_t pack_version = 1;
+    constexpr uint64_t blob_alignment = 64;
+
+    enum EntryFlags : uint32_t
+    {
+        ENTRY_DEFLATE = 1 << 0
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entry_count;
+        uint32_t names_size;
+        uint64_t toc_offset;
+        uint64_t names_offset;
+    };
+
+    struct Entry
+    {
+        uint64_t hash;
+        uint64_t offset;
+        uint64_t stored_size;
+        uint64_t size;
+        uint32_t flags;
+        uint32_t name_offset;
+        uint32_t name_length;
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 32);
+    static_assert(sizeof(Entry) == 48);
+
+    // Returns false and leaves loose files in use when the pack is missing
+    // or malformed. Not safe to call while other threads read files.
+    bool Mount(
+        const std::string& pack_path);
+
+    void Unmount();
+
+    // Contents of path if the mounted pack has it. Stored entries point
+    // into the mapping, deflated ones are inflated into storage.
+    std::optional<std::string_view> Contents(
+        const std::string& path,
+        std::vector<uint8_t>& storage);
+
+    // Serve path from disk from now on, for files changed while running
+    void Override(
+        const std::string& path);
+}
@@ -1,13 +1,47 @@
 #include "Parsing.hpp"
+
+#include <cmath>
+#include <cstdlib>
 #include <stdexcept>
 
-std::vector<Token> tokenize(std::string str)
+void TokenArena::Reset(
+    const size_t source_length)
+{
+    tokens.clear();
+
+    // Roughly one token per four characters of GLSL
+    tokens.reserve(
+        source_length / 4);
+}
+
+void TokenArena::Push(
+    const TokenKind type,
+    const std::string_view source,
+    const uint32_t from,
+    const uint32_t to)
 {
-    const std::string prefix = "<>+-&";
-    const std::string suffix = "=>&:";
+    tokens.push_back({
+        type,
+        source.substr(from, to - from),
+        from,
+        to
+    });
+}
+
+const std::vector<Token>& tokenize(
+    const std::string_view str,
+    TokenArena& arena)
+{
+    const std::string_view prefix = "<>+-&";
+    const std::string_view suffix = "=>&:";
 
     const size_t length = str.size();
 
+    // Reading past the end yields a terminator instead of padding the source.
+    const auto At = [&](const size_t i) -> char {
+        return i < length ? str[i] : '\0';
+    };
+
     // The current character.
     char character = ' ';
 
@@ -17,29 +51,20 @@ std::vector<Token> tokenize(std::string str)
     // The index of the current character.
     uint32_t index = 0;
 
-    // The number value.
-    double n_val;
-
     // The quote character.
     char q_val;
 
-    // The string value.
-    std::string s_val;
+    arena.Reset(length);
 
-    // An array to hold the results.
-    std::vector<Token> result;
-
-    if (str == "")
+    if (length == 0)
     {
-        return result;
+        return arena.Tokens();
     }
 
-    str = str + " ";
-
     // Loop through this text, one character at a time.
 
-    character = str.at(index);
-    while (character)
+    character = At(index);
+    while (index < length)
     {
         from = index;
 
@@ -47,32 +72,23 @@ std::vector<Token> tokenize(std::string str)
 
         if (character <= ' ')
         {
-            if (index == length)
-            {
-                return result;
-            }
-            else
-            {
-                index += 1;
-                character = str.at(index);
-            }
+            index += 1;
+            character = At(index);
             // name.
         }
         else if (
             (character >= 'a' && character <= 'z') ||
             (character >= 'A' && character <= 'Z'))
         {
-            s_val = character;
             index += 1;
             for (;;)
             {
-                character = str.at(index);
+                character = At(index);
                 if ((character >= 'a' && character <= 'z') ||
                     (character >= 'A' && character <= 'Z') ||
                     (character >= '0' && character <= '9') ||
                     (character == '_'))
                 {
-                    s_val += character;
                     index += 1;
                 }
                 else
@@ -81,12 +97,11 @@ std::vector<Token> tokenize(std::string str)
                 }
             }
 
-            result.push_back({
-                "name",
-                s_val,
+            arena.Push(
+                TokenKind::NAME,
+                str,
                 from,
-                index
-            });
+                index);
 
             // number.
 
@@ -95,20 +110,18 @@ std::vector<Token> tokenize(std::string str)
         }
         else if (character >= '0' && character <= '9')
         {
-            s_val = character;
             index += 1;
 
             // Look for more digits.
 
             for (;;)
             {
-                character = str.at(index);
+                character = At(index);
                 if (character < '0' || character > '9')
                 {
                     break;
                 }
                 index += 1;
-                s_val += character;
             }
 
             // Look for a decimal fraction part.
@@ -116,16 +129,14 @@ std::vector<Token> tokenize(std::string str)
             if (character == '.')
             {
                 index += 1;
-                s_val += character;
                 for (;;)
                 {
-                    character = str.at(index);
+                    character = At(index);
                     if (character < '0' || character > '9')
                     {
                         break;
                     }
                     index += 1;
-                    s_val += character;
                 }
             }
 
@@ -134,13 +145,11 @@ std::vector<Token> tokenize(std::string str)
             if (character == 'e' || character == 'E')
             {
                 index += 1;
-                s_val += character;
-                character = str.at(index);
+                character = At(index);
                 if (character == '-' || character == '+')
                 {
                     index += 1;
-                    s_val += character;
-                    character = str.at(index);
+                    character = At(index);
                 }
                 if (character < '0' || character > '9')
                 {
@@ -150,49 +159,52 @@ std::vector<Token> tokenize(std::string str)
                 do
                 {
                     index += 1;
-                    s_val += character;
-                    character = str.at(index);
+                    character = At(index);
                 }
                 while (character >= '0' && character <= '9');
             }
 
-            // Make sure the next character is not a letter.
+            const uint32_t number_end = index;
+
+            // Make sure the next character is not a letter,
+            // other than the GLSL float suffix.
 
             if (character >= 'a' && character <= 'z')
             {
                 if (character != 'f')
                 {
-                    s_val += character;
-                    index += 1;
                     throw std::runtime_error(
                         "Bad number");
                 }
+                index += 1;
+                character = At(index);
             }
 
             // Convert the string value to a number.
             // If it is finite, then it is a good token.
+            // Numbers are short, so convert from a stack copy.
 
-            try
-            {
-                n_val = stof(s_val);
-            }
-            catch (const std::invalid_argument& e)
-            {
-                throw std::runtime_error(e.what());
-            }
-            catch (const std::out_of_range& e)
+            char n_str[64];
+            const size_t n_length = number_end - from;
+
+            if (n_length >= sizeof(n_str))
             {
-                throw std::runtime_error(e.what());
+                throw std::runtime_error(
+                    "Bad Number.");
             }
 
-            if (isfinite(n_val))
+            str.copy(n_str, n_length, from);
+            n_str[n_length] = '\0';
+
+            const float n_val = std::strtof(n_str, nullptr);
+
+            if (std::isfinite(n_val))
             {
-                result.push_back({
-                    "number",
-                    s_val,
+                arena.Push(
+                    TokenKind::NUMBER,
+                    str,
                     from,
-                    index
-                });
+                    index);
             }
             else
             {
@@ -205,12 +217,11 @@ std::vector<Token> tokenize(std::string str)
         }
         else if (character == '\'' || character == '"')
         {
-            s_val = ' ';
             q_val = character;
             index += 1;
             for (;;)
             {
-                character = str.at(index);
+                character = At(index);
                 if (character < ' ')
                 {
                     if (character == '\n' || character == '\r' || !character)
@@ -231,7 +242,7 @@ std::vector<Token> tokenize(std::string str)
                     break;
                 }
 
-                // Look for escapement.
+                // Look for escapement, the value keeps the escape as written.
 
                 if (character == '\\')
                 {
@@ -241,78 +252,29 @@ std::vector<Token> tokenize(std::string str)
                         throw std::runtime_error(
                             "Unterminated string.");
                     }
-                    character = str.at(index);
-                    switch (character)
+                    if (At(index) == 'u')
                     {
-                    case 'b':
-                        character = '\b';
-                        break;
-                    case 'f':
-                        character = '\f';
-                        break;
-                    case 'n':
-                        character = '\n';
-                        break;
-                    case 'r':
-                        character = '\r';
-                        break;
-                    case 't':
-                        character = '\t';
-                        break;
-                    case 'u':
-                        if (index >= length)
-                        {
-                            throw std::runtime_error(
-                                "Unterminated string.");
-                        }
-
-                        uint16_t c = 0;
-
-                        try
-                        {
-                            c = std::stoi(str.substr(index + 1, 4));
-                        }
-                        catch (const std::invalid_argument& e)
-                        {
-                            throw std::runtime_error(e.what());
-                        }
-                        catch (const std::out_of_range& e)
-                        {
-                            throw std::runtime_error(e.what());
-                        }
-
-                        if (character < 0)
-                        {
-                            throw std::runtime_error(
-                                "Unterminated string.");
-                        }
-
-                        //character = String.fromCharCode(c);
                         throw std::runtime_error(
                             "Unicode unsupported.");
-                        index += 4;
-                        break;
                     }
                 }
-                s_val += character;
                 index += 1;
             }
             index += 1;
-            result.push_back({
-                "string",
-                s_val,
-                from,
-                index
-            });
-            character = str.at(index);
+            arena.Push(
+                TokenKind::STRING,
+                str,
+                from + 1,
+                index - 1);
+            character = At(index);
             // comment.
         }
-        else if (character == '/' && str.at(index + 1) == '/')
+        else if (character == '/' && At(index + 1) == '/')
         {
             index += 1;
             for (;;)
             {
-                character = str.at(index);
+                character = At(index);
                 if (character == '\n' || character == '\r' || !character)
                 {
                     break;
@@ -321,40 +283,36 @@ std::vector<Token> tokenize(std::string str)
             }
             // combining
         }
-        else if (prefix.find(character) != std::string::npos)
+        else if (prefix.find(character) != std::string_view::npos)
         {
-            s_val = character;
             index += 1;
             while (true)
             {
-                character = str.at(index);
+                character = At(index);
                 if (index >= length || suffix.find(character) ==
-                    std::string::npos)
+                    std::string_view::npos)
                 {
                     break;
                 }
-                str += character;
                 index += 1;
             }
-            result.push_back({
-                "operator",
-                s_val,
+            arena.Push(
+                TokenKind::OPERATOR,
+                str,
                 from,
-                index
-            });
+                index);
             // single-character operator
         }
         else
         {
             index += 1;
-            result.push_back({
-                "operator",
-                std::string(&character, 1),
+            arena.Push(
+                TokenKind::OPERATOR,
+                str,
                 from,
-                index
-            });
-            character = str.at(index);
+                index);
+            character = At(index);
         }
     }
-    return result;
+    return arena.Tokens();
 }
@@ -2,14 +2,52 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
+#include <string_view>
 
+enum class TokenKind : uint8_t
+{
+    NONE,
+    NAME,
+    NUMBER,
+    STRING,
+    OPERATOR
+};
+
+// Tokens view into the tokenized source, which must outlive them.
+// String values are the raw text between the quotes.
 struct Token
 {
-    std::string type = "";
-    std::string value = "";
+    TokenKind type = TokenKind::NONE;
+    std::string_view value;
     uint32_t from = 0;
     uint32_t to = 0;
 };
 
+// Token storage that keeps its capacity between runs, so tokenizing a
+// library of shaders with one arena only allocates for the largest.
+class TokenArena
+{
+private:
+    std::vector<Token> tokens;
+
+public:
+    void Reset(
+        const size_t source_length);
+
+    void Push(
+        const TokenKind type,
+        const std::string_view source,
+        const uint32_t from,
+        const uint32_t to);
+
+    const std::vector<Token>& Tokens() const
+    {
+        return tokens;
+    }
+};
+
 // Adapted from Douglas Crockford's JS tokenizer
-std::vector<Token> tokenize(std::string str);
+const std::vector<Token>& tokenize(
+    const std::string_view str,
+    TokenArena& arena);
@@ -6,6 +6,7 @@
 
 #include "gl/OpenGL.hpp"
 #include "gl/Pipeline.hpp"
+#include "gl/ComputePipeline.hpp"
 #include "gl/Shader.hpp"
 #include "gl/Descriptor.hpp"
 #include "gl/Texture2D.hpp"
@@ -0,0 +1,236 @@
+#include "Snapshot.hpp"
+
+#include "File.hpp"
+#include "Hash.hpp"
+
+#include <mutex>
+#include <iostream>
+#include <stdexcept>
+#include <filesystem>
+#include <unordered_map>
+
+namespace Snapshot
+{
+    struct Record
+    {
+        std::string kind;
+        uint64_t key;
+        std::string payload;
+        bool used;
+    };
+
+    static std::mutex mutex;
+    static std::unordered_map<uint64_t, Record> records;
+    static bool dirty = false;
+
+    uint64_t RecordId(
+        const std::string& kind,
+        const uint64_t key)
+    {
+        return hash_fnv1a(
+            &key,
+            sizeof(key),
+            hash_fnv1a(kind));
+    }
+
+    bool Load(
+        const std::string& path)
+    {
+        std::error_code error;
+
+        if (!std::filesystem::exists(path, error))
+        {
+            return false;
+        }
+
+        std::unordered_map<uint64_t, Record> loaded;
+
+        try
+        {
+            File file(path, "rb");
+
+            Header header = {};
+
+            const bool valid =
+                file.Read(&header, sizeof(Header), 1) == 1 &&
+                header.magic == snapshot_magic &&
+                header.version == snapshot_version;
+
+            if (!valid)
+            {
+                throw std::runtime_error("version mismatch");
+            }
+
+            for (uint32_t i = 0; i < header.record_count; i++)
+            {
+                Record record = {};
+                record.kind = file.ReadStringPrefixed();
+
+                uint64_t length = 0;
+                uint64_t payload_hash = 0;
+
+                const bool header_read =
+                    file.Read(&record.key, sizeof(uint64_t), 1) == 1 &&
+                    file.Read(&length, sizeof(uint64_t), 1) == 1 &&
+                    file.Read(&payload_hash, sizeof(uint64_t), 1) == 1 &&
+                    length <= file.Length();
+
+                if (!header_read)
+                {
+                    throw std::runtime_error("truncated");
+                }
+
+                record.payload.resize(length);
+
+                const bool payload_read =
+                    file.Read(record.payload.data(), 1, length) == length &&
+                    hash_fnv1a(record.payload) == payload_hash;
+
+                if (!payload_read)
+                {
+                    throw std::runtime_error("corrupt record " + record.kind);
+                }
+
+                loaded.emplace(
+                    RecordId(record.kind, record.key),
+                    std::move(record));
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "Discarding snapshot " << path << ": " << e.what() << std::endl;
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        records = std::move(loaded);
+        dirty = false;
+
+        return true;
+    }
+
+    void Save(
+        const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        size_t used_count = 0;
+
+        for (const auto& record : records)
+        {
+            used_count += record.second.used ? 1 : 0;
+        }
+
+        // Nothing new and nothing dropped, the file on disk is current
+        if (!dirty && used_count == records.size())
+        {
+            return;
+        }
+
+        const std::string temporary_path = path + ".tmp";
+
+        try
+        {
+            std::error_code error;
+            std::filesystem::create_directories(
+                std::filesystem::path(path).parent_path(),
+                error);
+
+            {
+                File file(temporary_path, "wb");
+
+                const Header header = {
+                    snapshot_magic,
+                    snapshot_version,
+                    static_cast<uint32_t>(used_count),
+                    0
+                };
+
+                file.Write(&header, sizeof(Header), 1);
+
+                for (const auto& entry : records)
+                {
+                    const Record& record = entry.second;
+
+                    if (!record.used)
+                    {
+                        continue;
+                    }
+
+                    const uint64_t length = record.payload.size();
+                    const uint64_t payload_hash = hash_fnv1a(record.payload);
+
+                    file.WriteStringPrefixed(record.kind);
+                    file.Write(&record.key, sizeof(uint64_t), 1);
+                    file.Write(&length, sizeof(uint64_t), 1);
+                    file.Write(&payload_hash, sizeof(uint64_t), 1);
+                    file.Write(record.payload.data(), 1, length);
+                }
+            }
+
+            std::filesystem::rename(
+                temporary_path,
+                path);
+
+            dirty = false;
+        }
+        catch (const std::exception&)
+        {
+            // Best effort, the next launch just starts cold
+            std::error_code error;
+            std::filesystem::remove(temporary_path, error);
+        }
+    }
+
+    std::optional<std::string_view> Find(
+        const std::string& kind,
+        const uint64_t key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const auto it = records.find(
+            RecordId(kind, key));
+
+        if (it == records.end() ||
+            it->second.kind != kind ||
+            it->second.key != key)
+        {
+            return std::nullopt;
+        }
+
+        it->second.used = true;
+
+        return std::string_view(
+            it->second.payload);
+    }
+
+    void Store(
+        const std::string& kind,
+        const uint64_t key,
+        std::string payload)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        records[RecordId(kind, key)] = {
+            kind,
+            key,
+            std::move(payload),
+            true
+        };
+
+        dirty = true;
+    }
+
+    void Erase(
+        const std::string& kind,
+        const uint64_t key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (records.erase(RecordId(kind, key)) > 0)
+        {
+            dirty = true;
+        }
+    }
+}
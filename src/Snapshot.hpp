@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Warm-start snapshot of derived state, written on clean shutdown and read
+// at startup. Records are identified by a kind and a key hash of their
+// inputs, so stale ones simply miss. Only records used during a run are
+// written back, the file never accumulates dead entries.
+//
+// Layout: Header, then per record a ReadStringPrefixed kind, the key, the
+// payload length and FNV hash, and the payload.
+namespace Snapshot
+{
+    constexpr uint32_t snapshot_magic = 0x50414E53; // "SNAP"
+    constexpr uint32_t snapshot_version = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t record_count;
+        uint32_t reserved;
+    };
+
+    // False when there is no usable snapshot, everything is then rebuilt
+    bool Load(
+        const std::string& path);
+
+    // Written to a temporary and renamed, a crash never leaves half a file
+    void Save(
+        const std::string& path);
+
+    // The view stays valid until the same record is stored again
+    std::optional<std::string_view> Find(
+        const std::string& kind,
+        const uint64_t key);
+
+    void Store(
+        const std::string& kind,
+        const uint64_t key,
+        std::string payload);
+
+    void Erase(
+        const std::string& kind,
+        const uint64_t key);
+}
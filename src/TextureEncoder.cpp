@@ -0,0 +1,744 @@
+#include "TextureEncoder.hpp"
+
+#include <glm/gtc/packing.hpp>
+#include <glm/matrix.hpp>
+
+#include <cmath>
+#include <array>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+namespace TextureEncoder
+{
+    constexpr int rgb9e5_mantissa_bits = 9;
+    constexpr int rgb9e5_bias = 15;
+    constexpr int rgb9e5_max_exponent = 31;
+    constexpr float rgb9e5_max = 65408.0f;
+
+    constexpr uint32_t bc6h_block_bytes = 16;
+    constexpr uint32_t bc6h_mode_11 = 0x03;
+    constexpr uint32_t bc6h_endpoint_bits = 10;
+    constexpr float bc6h_max_half = 65504.0f;
+    constexpr int bc6h_refine_iterations = 2;
+
+    constexpr std::array<int, 16> bc6h_weights = {
+        0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64
+    };
+
+    struct ErrorSums
+    {
+        double squared = 0.0;
+        double log_squared = 0.0;
+        double max = 0.0;
+        uint64_t count = 0;
+
+        void Add(
+            const glm::vec4& source,
+            const glm::vec3& decoded)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                if (!std::isfinite(source[c]))
+                {
+                    continue;
+                }
+
+                const double error = std::abs(double(source[c]) - decoded[c]);
+
+                const double log_error =
+                    std::log2(1.0 + std::max(double(source[c]), 0.0)) -
+                    std::log2(1.0 + decoded[c]);
+
+                squared += error * error;
+                log_squared += log_error * log_error;
+                max = std::max(max, error);
+            }
+
+            count++;
+        }
+
+        void Add(
+            const ErrorSums& other)
+        {
+            squared += other.squared;
+            log_squared += other.log_squared;
+            max = std::max(max, other.max);
+            count += other.count;
+        }
+
+        ErrorReport Report() const
+        {
+            ErrorReport report;
+
+            if (count > 0)
+            {
+                const double samples = double(count) * 3.0;
+
+                report.rmse = std::sqrt(squared / samples);
+                report.log_rmse = std::sqrt(log_squared / samples);
+                report.max_error = max;
+                report.texels = count;
+            }
+
+            return report;
+        }
+    };
+
+    // Calls encode(first_row, end_row, sums) for contiguous row ranges on
+    // up to threads threads and merges their error sums
+    template <typename F>
+    ErrorReport ForRows(
+        const uint32_t rows,
+        uint32_t threads,
+        F encode)
+    {
+        if (threads == 0)
+        {
+            threads = std::max(std::thread::hardware_concurrency(), 1u);
+        }
+
+        threads = std::min(threads, std::max(rows, 1u));
+
+        std::vector<ErrorSums> sums(threads);
+        std::vector<std::thread> workers;
+
+        const uint32_t rows_per_thread = (rows + threads - 1) / threads;
+
+        for (uint32_t t = 0; t < threads; t++)
+        {
+            const uint32_t begin = std::min(t * rows_per_thread, rows);
+            const uint32_t end = std::min(begin + rows_per_thread, rows);
+
+            workers.emplace_back(
+                [&encode, &sums, t, begin, end]() {
+                    encode(begin, end, sums[t]);
+                });
+        }
+
+        ErrorSums total;
+
+        for (uint32_t t = 0; t < threads; t++)
+        {
+            workers[t].join();
+            total.Add(sums[t]);
+        }
+
+        return total.Report();
+    }
+
+    void CheckSize(
+        const std::vector<glm::vec4>& texels,
+        const uint32_t width,
+        const uint32_t height)
+    {
+        if (width == 0 || height == 0 ||
+            texels.size() != static_cast<size_t>(width) * height)
+        {
+            throw std::runtime_error(
+                "Texel count doesn't match the image size");
+        }
+    }
+
+    glm::vec3 Sanitize(
+        const glm::vec4& texel,
+        const float max_value)
+    {
+        glm::vec3 rgb = glm::vec3(texel);
+
+        rgb = glm::mix(
+            rgb,
+            glm::vec3(0.0f),
+            glm::isnan(rgb));
+
+        return glm::clamp(
+            rgb,
+            0.0f,
+            max_value);
+    }
+
+    uint32_t PackRGB9E5(
+        const glm::vec4& texel,
+        glm::vec3& decoded)
+    {
+        const glm::vec3 rgb = Sanitize(
+            texel,
+            rgb9e5_max);
+
+        const float max_channel = std::max(
+            rgb.r,
+            std::max(rgb.g, rgb.b));
+
+        // Below the smallest exponent everything rounds to zero anyway
+        const int max_exponent = max_channel > 0.0f ?
+            static_cast<int>(std::floor(std::log2(max_channel))) :
+            -rgb9e5_bias - 1;
+
+        int exponent = std::max(-rgb9e5_bias - 1, max_exponent) +
+            1 + rgb9e5_bias;
+
+        float scale = std::exp2(static_cast<float>(
+            exponent - rgb9e5_bias - rgb9e5_mantissa_bits));
+
+        if (std::floor(max_channel / scale + 0.5f) ==
+            static_cast<float>(1 << rgb9e5_mantissa_bits))
+        {
+            exponent++;
+            scale *= 2.0f;
+        }
+
+        exponent = std::min(exponent, rgb9e5_max_exponent);
+
+        const glm::uvec3 mantissa = glm::uvec3(
+            glm::floor(rgb / scale + 0.5f));
+
+        decoded = glm::vec3(mantissa) * scale;
+
+        return
+            mantissa.r |
+            mantissa.g << 9 |
+            mantissa.b << 18 |
+            static_cast<uint32_t>(exponent) << 27;
+    }
+
+    Encoded EncodeRGB9E5(
+        const std::vector<glm::vec4>& texels,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t threads)
+    {
+        CheckSize(
+            texels,
+            width,
+            height);
+
+        Encoded encoded = {
+            Ktx2::E5B9G9R9_UFLOAT_PACK32,
+            width,
+            height,
+            std::vector<uint8_t>(texels.size() * sizeof(uint32_t)),
+            {}
+        };
+
+        uint32_t* output = reinterpret_cast<uint32_t*>(
+            encoded.data.data());
+
+        encoded.error = ForRows(
+            height,
+            threads,
+            [&](const uint32_t begin, const uint32_t end, ErrorSums& sums) {
+                for (size_t i = size_t(begin) * width; i < size_t(end) * width; i++)
+                {
+                    glm::vec3 decoded;
+
+                    output[i] = PackRGB9E5(
+                        texels[i],
+                        decoded);
+
+                    sums.Add(
+                        texels[i],
+                        decoded);
+                }
+            });
+
+        return encoded;
+    }
+
+    // BC6H unsigned blocks interpolate half float bit patterns as
+    // integers, so endpoints are fitted in that space rather than in
+    // linear light.
+    struct Block
+    {
+        std::array<glm::vec4, 16> source;
+        std::array<glm::vec3, 16> half_bits;
+    };
+
+    struct Endpoints
+    {
+        glm::uvec3 a;
+        glm::uvec3 b;
+    };
+
+    uint32_t QuantizeEndpoint(
+        const float half_bits)
+    {
+        // Inverse of the decoder's (q << 6) + 32 followed by * 31 >> 6
+        const float unquantized = half_bits * 64.0f / 31.0f;
+
+        return static_cast<uint32_t>(std::clamp(
+            std::round((unquantized - 32.0f) / 64.0f),
+            0.0f,
+            float((1 << bc6h_endpoint_bits) - 1)));
+    }
+
+    glm::uvec3 QuantizeEndpoint(
+        const glm::vec3& half_bits)
+    {
+        return {
+            QuantizeEndpoint(half_bits.r),
+            QuantizeEndpoint(half_bits.g),
+            QuantizeEndpoint(half_bits.b)
+        };
+    }
+
+    int UnquantizeEndpoint(
+        const uint32_t q)
+    {
+        if (q == 0)
+        {
+            return 0;
+        }
+
+        if (q == (1u << bc6h_endpoint_bits) - 1)
+        {
+            return 0xFFFF;
+        }
+
+        return static_cast<int>((q << 6) + 32);
+    }
+
+    // The decoder's output for every index, as half float bit patterns
+    std::array<glm::vec3, 16> Palette(
+        const Endpoints& endpoints)
+    {
+        std::array<glm::vec3, 16> palette;
+
+        for (size_t i = 0; i < palette.size(); i++)
+        {
+            const int w = bc6h_weights[i];
+
+            for (int c = 0; c < 3; c++)
+            {
+                const int a = UnquantizeEndpoint(endpoints.a[c]);
+                const int b = UnquantizeEndpoint(endpoints.b[c]);
+                const int interpolated = ((64 - w) * a + w * b + 32) >> 6;
+
+                palette[i][c] = static_cast<float>((interpolated * 31) >> 6);
+            }
+        }
+
+        return palette;
+    }
+
+    float AssignIndices(
+        const Block& block,
+        const std::array<glm::vec3, 16>& palette,
+        std::array<uint8_t, 16>& indices)
+    {
+        float total = 0.0f;
+
+        for (size_t t = 0; t < block.half_bits.size(); t++)
+        {
+            float best = std::numeric_limits<float>::max();
+
+            for (size_t i = 0; i < palette.size(); i++)
+            {
+                const glm::vec3 delta = palette[i] - block.half_bits[t];
+                const float distance = glm::dot(delta, delta);
+
+                if (distance < best)
+                {
+                    best = distance;
+                    indices[t] = static_cast<uint8_t>(i);
+                }
+            }
+
+            total += best;
+        }
+
+        return total;
+    }
+
+    void PrincipalAxis(
+        const Block& block,
+        glm::vec3& mean,
+        glm::vec3& axis)
+    {
+        mean = glm::vec3(0.0f);
+
+        for (const auto& texel : block.half_bits)
+        {
+            mean += texel;
+        }
+
+        mean /= float(block.half_bits.size());
+
+        glm::mat3 covariance(0.0f);
+
+        for (const auto& texel : block.half_bits)
+        {
+            const glm::vec3 d = texel - mean;
+            covariance += glm::outerProduct(d, d);
+        }
+
+        // Power iteration, a few steps settle on 3x3
+        axis = glm::vec3(1.0f);
+
+        for (int i = 0; i < 8; i++)
+        {
+            const glm::vec3 next = covariance * axis;
+            const float length = glm::length(next);
+
+            if (length < 1e-6f)
+            {
+                break;
+            }
+
+            axis = next / length;
+        }
+
+        axis = glm::normalize(axis);
+    }
+
+    // Best a and b for fixed indices, minimising the squared distance of
+    // (1 - w) * a + w * b to every texel
+    bool LeastSquares(
+        const Block& block,
+        const std::array<uint8_t, 16>& indices,
+        glm::vec3& a,
+        glm::vec3& b)
+    {
+        float aa = 0.0f;
+        float ab = 0.0f;
+        float bb = 0.0f;
+        glm::vec3 ax(0.0f);
+        glm::vec3 bx(0.0f);
+
+        for (size_t t = 0; t < block.half_bits.size(); t++)
+        {
+            const float w = bc6h_weights[indices[t]] / 64.0f;
+
+            aa += (1.0f - w) * (1.0f - w);
+            ab += (1.0f - w) * w;
+            bb += w * w;
+            ax += (1.0f - w) * block.half_bits[t];
+            bx += w * block.half_bits[t];
+        }
+
+        const float determinant = aa * bb - ab * ab;
+
+        if (std::abs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+
+        a = (ax * bb - bx * ab) / determinant;
+        b = (bx * aa - ax * ab) / determinant;
+
+        return true;
+    }
+
+    Endpoints FitEndpoints(
+        const Block& block,
+        const Quality quality)
+    {
+        glm::vec3 low(std::numeric_limits<float>::max());
+        glm::vec3 high(0.0f);
+
+        for (const auto& texel : block.half_bits)
+        {
+            low = glm::min(low, texel);
+            high = glm::max(high, texel);
+        }
+
+        if (quality == Quality::FAST)
+        {
+            return {
+                QuantizeEndpoint(low),
+                QuantizeEndpoint(high)
+            };
+        }
+
+        glm::vec3 mean;
+        glm::vec3 axis;
+
+        PrincipalAxis(
+            block,
+            mean,
+            axis);
+
+        float min_projection = std::numeric_limits<float>::max();
+        float max_projection = std::numeric_limits<float>::lowest();
+
+        for (const auto& texel : block.half_bits)
+        {
+            const float projection = glm::dot(texel - mean, axis);
+
+            min_projection = std::min(min_projection, projection);
+            max_projection = std::max(max_projection, projection);
+        }
+
+        // Ends of the axis can leave the block's range in other channels,
+        // which is costly once the half float bits are decoded
+        const Endpoints axis_endpoints = {
+            QuantizeEndpoint(glm::clamp(mean + axis * min_projection, low, high)),
+            QuantizeEndpoint(glm::clamp(mean + axis * max_projection, low, high))
+        };
+
+        const Endpoints box_endpoints = {
+            QuantizeEndpoint(low),
+            QuantizeEndpoint(high)
+        };
+
+        std::array<uint8_t, 16> indices;
+
+        Endpoints best = axis_endpoints;
+
+        float best_error = AssignIndices(
+            block,
+            Palette(axis_endpoints),
+            indices);
+
+        std::array<uint8_t, 16> box_indices;
+
+        const float box_error = AssignIndices(
+            block,
+            Palette(box_endpoints),
+            box_indices);
+
+        if (box_error < best_error)
+        {
+            best = box_endpoints;
+            best_error = box_error;
+            indices = box_indices;
+        }
+
+        if (quality == Quality::NORMAL)
+        {
+            return best;
+        }
+
+        for (int i = 0; i < bc6h_refine_iterations; i++)
+        {
+            glm::vec3 a;
+            glm::vec3 b;
+
+            if (!LeastSquares(block, indices, a, b))
+            {
+                break;
+            }
+
+            const Endpoints refined = {
+                QuantizeEndpoint(glm::clamp(a, low, high)),
+                QuantizeEndpoint(glm::clamp(b, low, high))
+            };
+
+            const float error = AssignIndices(
+                block,
+                Palette(refined),
+                indices);
+
+            if (error >= best_error)
+            {
+                break;
+            }
+
+            best = refined;
+            best_error = error;
+        }
+
+        return best;
+    }
+
+    class BitWriter
+    {
+    private:
+        uint8_t* output;
+        uint32_t position = 0;
+
+    public:
+        BitWriter(uint8_t* output) :
+            output(output)
+        {
+        }
+
+        // Least significant bit first, as the block is read
+        void Write(
+            const uint32_t value,
+            const uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; i++, position++)
+            {
+                output[position / 8] |= ((value >> i) & 1) << (position % 8);
+            }
+        }
+    };
+
+    void EncodeBlock(
+        const Block& block,
+        const Quality quality,
+        uint8_t* output,
+        std::array<glm::vec3, 16>& decoded)
+    {
+        Endpoints endpoints = FitEndpoints(
+            block,
+            quality);
+
+        std::array<uint8_t, 16> indices;
+
+        const std::array<glm::vec3, 16> palette = Palette(
+            endpoints);
+
+        AssignIndices(
+            block,
+            palette,
+            indices);
+
+        for (size_t t = 0; t < indices.size(); t++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                decoded[t][c] = glm::unpackHalf1x16(
+                    static_cast<uint16_t>(palette[indices[t]][c]));
+            }
+        }
+
+        // The first index is stored without its top bit, swapping the
+        // endpoints mirrors the palette since the weights are symmetric
+        if (indices[0] >= 8)
+        {
+            std::swap(endpoints.a, endpoints.b);
+
+            for (auto& index : indices)
+            {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        std::fill(output, output + bc6h_block_bytes, 0);
+
+        BitWriter writer(output);
+
+        writer.Write(bc6h_mode_11, 5);
+
+        for (int c = 0; c < 3; c++)
+        {
+            writer.Write(endpoints.a[c], bc6h_endpoint_bits);
+        }
+
+        for (int c = 0; c < 3; c++)
+        {
+            writer.Write(endpoints.b[c], bc6h_endpoint_bits);
+        }
+
+        writer.Write(indices[0], 3);
+
+        for (size_t t = 1; t < indices.size(); t++)
+        {
+            writer.Write(indices[t], 4);
+        }
+    }
+
+    Encoded EncodeBC6H(
+        const std::vector<glm::vec4>& texels,
+        const uint32_t width,
+        const uint32_t height,
+        const Quality quality,
+        const uint32_t threads)
+    {
+        CheckSize(
+            texels,
+            width,
+            height);
+
+        const uint32_t blocks_x = (width + 3) / 4;
+        const uint32_t blocks_y = (height + 3) / 4;
+
+        Encoded encoded = {
+            Ktx2::BC6H_UFLOAT_BLOCK,
+            width,
+            height,
+            std::vector<uint8_t>(size_t(blocks_x) * blocks_y * bc6h_block_bytes),
+            {}
+        };
+
+        encoded.error = ForRows(
+            blocks_y,
+            threads,
+            [&](const uint32_t begin, const uint32_t end, ErrorSums& sums) {
+                Block block;
+                std::array<glm::vec3, 16> decoded;
+
+                for (uint32_t by = begin; by < end; by++)
+                {
+                    for (uint32_t bx = 0; bx < blocks_x; bx++)
+                    {
+                        for (uint32_t t = 0; t < 16; t++)
+                        {
+                            // Edge blocks repeat the last row and column
+                            const uint32_t x = std::min(bx * 4 + t % 4, width - 1);
+                            const uint32_t y = std::min(by * 4 + t / 4, height - 1);
+
+                            const glm::vec4& texel = texels[size_t(y) * width + x];
+                            const glm::vec3 rgb = Sanitize(texel, bc6h_max_half);
+
+                            block.source[t] = texel;
+
+                            for (int c = 0; c < 3; c++)
+                            {
+                                block.half_bits[t][c] = static_cast<float>(
+                                    glm::packHalf1x16(rgb[c]));
+                            }
+                        }
+
+                        EncodeBlock(
+                            block,
+                            quality,
+                            encoded.data.data() +
+                                (size_t(by) * blocks_x + bx) * bc6h_block_bytes,
+                            decoded);
+
+                        for (uint32_t t = 0; t < 16; t++)
+                        {
+                            if (bx * 4 + t % 4 < width && by * 4 + t / 4 < height)
+                            {
+                                sums.Add(
+                                    block.source[t],
+                                    decoded[t]);
+                            }
+                        }
+                    }
+                }
+            });
+
+        return encoded;
+    }
+
+    std::vector<glm::vec4> Downsample(
+        const std::vector<glm::vec4>& texels,
+        const uint32_t width,
+        const uint32_t height)
+    {
+        CheckSize(
+            texels,
+            width,
+            height);
+
+        const uint32_t half_width = std::max(width / 2, 1u);
+        const uint32_t half_height = std::max(height / 2, 1u);
+
+        std::vector<glm::vec4> output(
+            size_t(half_width) * half_height);
+
+        for (uint32_t y = 0; y < half_height; y++)
+        {
+            const uint32_t y0 = std::min(y * 2, height - 1);
+            const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+
+            for (uint32_t x = 0; x < half_width; x++)
+            {
+                const uint32_t x0 = std::min(x * 2, width - 1);
+                const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+
+                output[size_t(y) * half_width + x] = 0.25f * (
+                    texels[size_t(y0) * width + x0] +
+                    texels[size_t(y0) * width + x1] +
+                    texels[size_t(y1) * width + x0] +
+                    texels[size_t(y1) * width + x1]);
+            }
+        }
+
+        return output;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Ktx2.hpp"
+#include "math/Math.hpp"
+
+#include <vector>
+#include <cstdint>
+
+// CPU encoders for baking HDR images, such as sky maps rendered by
+// Pipelines::Atmosphere, into formats sampled directly from VRAM. Input
+// is RGBA32F with alpha ignored, output goes into a KTX2 level. Rows of
+// blocks are split across threads, texel math runs on glm vectors.
+namespace TextureEncoder
+{
+    enum class Quality
+    {
+        // Bounding box endpoints
+        FAST,
+        // Endpoints along the block's principal axis
+        NORMAL,
+        // Principal axis followed by least squares refinement
+        HIGH
+    };
+
+    // Against the source texels. Negative input counts as error since
+    // neither format stores it, non-finite channels are encoded as zero
+    // and left out.
+    struct ErrorReport
+    {
+        double rmse = 0.0;
+        double max_error = 0.0;
+
+        // RMSE of log2(1 + x), closer to how HDR error is perceived
+        double log_rmse = 0.0;
+
+        uint64_t texels = 0;
+    };
+
+    struct Encoded
+    {
+        Ktx2::Format format;
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> data;
+        ErrorReport error;
+    };
+
+    // 4 bytes per texel, 9 bit mantissas sharing one exponent. Core in
+    // GLES 3 and WebGL2. threads 0 uses every core.
+    Encoded EncodeRGB9E5(
+        const std::vector<glm::vec4>& texels,
+        const uint32_t width,
+        const uint32_t height,
+        const uint32_t threads = 0);
+
+    // 1 byte per texel, needs EXT_texture_compression_bptc. Every block
+    // uses the single region mode with 10 bit endpoints.
+    Encoded EncodeBC6H(
+        const std::vector<glm::vec4>& texels,
+        const uint32_t width,
+        const uint32_t height,
+        const Quality quality = Quality::NORMAL,
+        const uint32_t threads = 0);
+
+    // Next mip level with a 2x2 box filter, odd edges are clamped
+    std::vector<glm::vec4> Downsample(
+        const std::vector<glm::vec4>& texels,
+        const uint32_t width,
+        const uint32_t height);
+}
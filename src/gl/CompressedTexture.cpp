@@ -0,0 +1,418 @@
+#include "CompressedTexture.hpp"
+#include "State.hpp"
+
+#include <assert.h>
+#include <optional>
+#include <stdexcept>
+
+namespace GL
+{
+    // Touching one byte per page faults a level in before its upload
+    constexpr size_t page_stride = 4096;
+
+    struct GLFormat
+    {
+        GLenum internal_format;
+        GLenum format;
+        GLenum type;
+
+        // Empty when the format is core
+        const char* extension;
+    };
+
+    std::optional<GLFormat> FormatOf(
+        const Ktx2::Format format)
+    {
+#if defined(EMSCRIPTEN)
+        const char* etc2 = "WEBGL_compressed_texture_etc";
+        const char* astc = "WEBGL_compressed_texture_astc";
+        const char* bptc = "EXT_texture_compression_bptc";
+#else
+        const char* etc2 = "";
+        const char* astc = "GL_KHR_texture_compression_astc_ldr";
+        const char* bptc = "GL_EXT_texture_compression_bptc";
+#endif
+
+        switch (format)
+        {
+        case Ktx2::R8G8B8A8_UNORM:
+            return GLFormat { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, "" };
+        case Ktx2::R8G8B8A8_SRGB:
+            return GLFormat { GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, "" };
+        case Ktx2::R16G16B16A16_SFLOAT:
+            return GLFormat { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, "" };
+        case Ktx2::R32G32B32A32_SFLOAT:
+            return GLFormat { GL_RGBA32F, GL_RGBA, GL_FLOAT, "" };
+        case Ktx2::B10G11R11_UFLOAT_PACK32:
+            return GLFormat { GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, "" };
+        case Ktx2::E5B9G9R9_UFLOAT_PACK32:
+            return GLFormat { GL_RGB9_E5, GL_RGB, GL_UNSIGNED_INT_5_9_9_9_REV, "" };
+        case Ktx2::BC6H_UFLOAT_BLOCK:
+            return GLFormat { GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_EXT, 0, 0, bptc };
+        case Ktx2::ETC2_R8G8B8_UNORM_BLOCK:
+            return GLFormat { GL_COMPRESSED_RGB8_ETC2, 0, 0, etc2 };
+        case Ktx2::ETC2_R8G8B8_SRGB_BLOCK:
+            return GLFormat { GL_COMPRESSED_SRGB8_ETC2, 0, 0, etc2 };
+        case Ktx2::ETC2_R8G8B8A8_UNORM_BLOCK:
+            return GLFormat { GL_COMPRESSED_RGBA8_ETC2_EAC, 0, 0, etc2 };
+        case Ktx2::ETC2_R8G8B8A8_SRGB_BLOCK:
+            return GLFormat { GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC, 0, 0, etc2 };
+        case Ktx2::ASTC_4x4_UNORM_BLOCK:
+            return GLFormat { GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 0, 0, astc };
+        case Ktx2::ASTC_4x4_SRGB_BLOCK:
+            return GLFormat { GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR, 0, 0, astc };
+        case Ktx2::ASTC_6x6_UNORM_BLOCK:
+            return GLFormat { GL_COMPRESSED_RGBA_ASTC_6x6_KHR, 0, 0, astc };
+        case Ktx2::ASTC_6x6_SRGB_BLOCK:
+            return GLFormat { GL_COMPRESSED_SRGB8_ALPHA8_ASTC_6x6_KHR, 0, 0, astc };
+        case Ktx2::ASTC_8x8_UNORM_BLOCK:
+            return GLFormat { GL_COMPRESSED_RGBA_ASTC_8x8_KHR, 0, 0, astc };
+        case Ktx2::ASTC_8x8_SRGB_BLOCK:
+            return GLFormat { GL_COMPRESSED_SRGB8_ALPHA8_ASTC_8x8_KHR, 0, 0, astc };
+        }
+
+        return std::nullopt;
+    }
+
+    bool CompressedTexture::Supported(
+        const Ktx2::Format format)
+    {
+        const auto gl_format = FormatOf(
+            format);
+
+        return
+            gl_format.has_value() &&
+            (gl_format->extension[0] == '\0' ||
+                HasExtension(gl_format->extension));
+    }
+
+    std::string CompressedTexture::Choose(
+        const std::vector<std::string>& paths)
+    {
+        for (const auto& path : paths)
+        {
+            try
+            {
+                const MappedFile candidate(path);
+
+                const Ktx2::Image candidate_image = Ktx2::Parse(
+                    candidate.View(),
+                    path);
+
+                if (Supported(candidate_image.format))
+                {
+                    return path;
+                }
+            }
+            catch (const std::runtime_error&)
+            {
+                // Missing or unreadable variants are skipped
+            }
+        }
+
+        throw std::runtime_error(
+            "No supported texture format among " +
+            std::to_string(paths.size()) + " variants");
+    }
+
+    CompressedTexture::CompressedTexture(
+        const std::string& path)
+    {
+        Create(path);
+
+        for (size_t i = image.levels.size(); i-- > 0;)
+        {
+            UploadLevel(i);
+        }
+    }
+
+    CompressedTexture::CompressedTexture(
+        const std::string& path,
+        AssetLoader& loader,
+        const LoadPriority priority) :
+        loader(&loader)
+    {
+        Create(path);
+
+        // Smallest first, the loader queues are FIFO
+        for (size_t i = image.levels.size(); i-- > 0;)
+        {
+            const Ktx2::Level level = image.levels[i];
+
+            loads.push_back(loader.Request<bool>(
+                [file = file, level]() {
+                    volatile uint8_t sum = 0;
+
+                    for (uint64_t j = 0; j < level.length; j += page_stride)
+                    {
+                        sum += file->Data()[level.offset + j];
+                    }
+
+                    return true;
+                },
+                [this, i](bool&) {
+                    UploadLevel(i);
+                },
+                priority));
+        }
+    }
+
+    CompressedTexture::~CompressedTexture()
+    {
+        assert(!created);
+    }
+
+    void CompressedTexture::Create(
+        const std::string& path)
+    {
+        file = std::make_shared<MappedFile>(
+            path,
+            FileAccess::SEQUENTIAL);
+
+        image = Ktx2::Parse(
+            file->View(),
+            path);
+
+        const auto gl_format = FormatOf(
+            image.format);
+
+        if (!Supported(image.format))
+        {
+            throw std::runtime_error(
+                "Texture format not supported by this device: " + path);
+        }
+
+        internal_format = gl_format->internal_format;
+        format = gl_format->format;
+        type = gl_format->type;
+        target = image.layers > 0 ?
+            GL_TEXTURE_2D_ARRAY :
+            GL_TEXTURE_2D;
+
+        GLsizei levels = static_cast<GLsizei>(image.levels.size());
+
+        if (image.generate_mipmaps)
+        {
+            for (uint32_t size = std::max(image.width, image.height); size > 1; size /= 2)
+            {
+                levels++;
+            }
+        }
+
+        resident.assign(
+            image.levels.size(),
+            false);
+
+        created = true;
+
+        glGenTextures(
+            1, &gl_texture_handle);
+
+        State::ActiveTexture(
+            GL_TEXTURE0);
+
+        State::BindTexture(
+            target,
+            gl_texture_handle);
+
+        if (target == GL_TEXTURE_2D)
+        {
+            glTexStorage2D(
+                target,
+                levels,
+                internal_format,
+                image.width,
+                image.height);
+        }
+        else
+        {
+            glTexStorage3D(
+                target,
+                levels,
+                internal_format,
+                image.width,
+                image.height,
+                image.layers);
+        }
+
+        glTexParameteri(
+            target,
+            GL_TEXTURE_MAX_LEVEL,
+            levels - 1);
+
+        State::BindTexture(
+            target,
+            0);
+
+        UpdateBaseLevel();
+    }
+
+    void CompressedTexture::UploadLevel(
+        const size_t level)
+    {
+        const Ktx2::Level& source = image.levels[level];
+        const uint8_t* pixels = file->Data() + source.offset;
+        const GLsizei size = static_cast<GLsizei>(source.length);
+
+        State::ActiveTexture(
+            GL_TEXTURE0);
+
+        State::BindTexture(
+            target,
+            gl_texture_handle);
+
+        if (Ktx2::IsCompressed(image.format))
+        {
+            if (target == GL_TEXTURE_2D)
+            {
+                glCompressedTexSubImage2D(
+                    target,
+                    static_cast<GLint>(level),
+                    0,
+                    0,
+                    source.width,
+                    source.height,
+                    internal_format,
+                    size,
+                    pixels);
+            }
+            else
+            {
+                glCompressedTexSubImage3D(
+                    target,
+                    static_cast<GLint>(level),
+                    0,
+                    0,
+                    0,
+                    source.width,
+                    source.height,
+                    image.layers,
+                    internal_format,
+                    size,
+                    pixels);
+            }
+        }
+        else
+        {
+            if (target == GL_TEXTURE_2D)
+            {
+                glTexSubImage2D(
+                    target,
+                    static_cast<GLint>(level),
+                    0,
+                    0,
+                    source.width,
+                    source.height,
+                    format,
+                    type,
+                    pixels);
+            }
+            else
+            {
+                glTexSubImage3D(
+                    target,
+                    static_cast<GLint>(level),
+                    0,
+                    0,
+                    0,
+                    source.width,
+                    source.height,
+                    image.layers,
+                    format,
+                    type,
+                    pixels);
+            }
+
+            if (image.generate_mipmaps)
+            {
+                glGenerateMipmap(
+                    target);
+            }
+        }
+
+        GL::CheckError();
+
+        State::BindTexture(
+            target,
+            0);
+
+        if (!resident[level])
+        {
+            resident[level] = true;
+            resident_count++;
+        }
+
+        UpdateBaseLevel();
+
+        if (Resident())
+        {
+            // Every level is in GL storage, the mapping is no longer needed
+            file.reset();
+            loads.clear();
+        }
+    }
+
+    void CompressedTexture::UpdateBaseLevel()
+    {
+        size_t base_level = resident.size() - 1;
+
+        while (base_level > 0 && resident[base_level - 1] && resident[base_level])
+        {
+            base_level--;
+        }
+
+        State::ActiveTexture(
+            GL_TEXTURE0);
+
+        State::BindTexture(
+            target,
+            gl_texture_handle);
+
+        glTexParameteri(
+            target,
+            GL_TEXTURE_BASE_LEVEL,
+            static_cast<GLint>(base_level));
+
+        State::BindTexture(
+            target,
+            0);
+    }
+
+    uint32_t CompressedTexture::Width() const
+    {
+        return image.width;
+    }
+
+    uint32_t CompressedTexture::Height() const
+    {
+        return image.height;
+    }
+
+    bool CompressedTexture::Resident() const
+    {
+        return resident_count == resident.size();
+    }
+
+    void CompressedTexture::Delete()
+    {
+        if (loader != nullptr)
+        {
+            for (const LoadHandle handle : loads)
+            {
+                loader->Cancel(
+                    handle);
+            }
+        }
+
+        loads.clear();
+        file.reset();
+
+        if (created)
+        {
+            State::DeleteTexture(
+                gl_texture_handle);
+        }
+
+        created = false;
+    }
+}
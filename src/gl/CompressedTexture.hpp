@@ -0,0 +1,80 @@
+#pragma once
+
+#include "OpenGL.hpp"
+
+#include "../File.hpp"
+#include "../Ktx2.hpp"
+#include "../AssetLoader.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace GL
+{
+    // Texture read from a KTX2 file with its stored mip chain, block
+    // compressed or plain. Levels go from the mapped file straight into
+    // immutable storage. A streamed load uploads the smallest level first
+    // and lowers GL_TEXTURE_BASE_LEVEL as larger ones arrive, so a coarse
+    // image is usable within a frame or two.
+    class CompressedTexture : public GLTextureResource
+    {
+    private:
+        bool created = false;
+
+        std::shared_ptr<MappedFile> file;
+        Ktx2::Image image;
+
+        GLenum target = GL_TEXTURE_2D;
+        GLenum internal_format = 0;
+        GLenum format = 0;
+        GLenum type = 0;
+
+        std::vector<bool> resident;
+        size_t resident_count = 0;
+
+        AssetLoader* loader = nullptr;
+        std::vector<LoadHandle> loads;
+
+        void Create(
+            const std::string& path);
+
+        void UploadLevel(
+            const size_t level);
+
+        // Lowest level with every smaller one resident
+        void UpdateBaseLevel();
+
+    public:
+        // Uploads every level before returning
+        CompressedTexture(
+            const std::string& path);
+
+        // Allocates storage now, levels stream in through loader's Poll
+        CompressedTexture(
+            const std::string& path,
+            AssetLoader& loader,
+            const LoadPriority priority = LoadPriority::IMMEDIATE);
+
+        CompressedTexture(const CompressedTexture&) = delete;
+        virtual ~CompressedTexture();
+
+        uint32_t Width() const;
+        uint32_t Height() const;
+
+        // True once the full chain is uploaded
+        bool Resident() const;
+
+        void Delete();
+
+        // False when the device can't sample format, e.g. ASTC without
+        // KHR_texture_compression_astc_ldr
+        static bool Supported(
+            const Ktx2::Format format);
+
+        // First path this device can sample, for shipping ASTC, ETC2 and
+        // uncompressed variants of the same image. Throws if none fits.
+        static std::string Choose(
+            const std::vector<std::string>& paths);
+    };
+}
@@ -0,0 +1,139 @@
+#include "ComputePipeline.hpp"
+
+#include <sstream>
+#include <optional>
+#include <algorithm>
+
+namespace GL
+{
+    constexpr uint32_t preferred_invocations = 64;
+
+    std::string WorkgroupSize::Defines() const
+    {
+        std::stringstream defines;
+        defines << "#define WORKGROUP_SIZE_X " << x << std::endl;
+        defines << "#define WORKGROUP_SIZE_Y " << y << std::endl;
+        return defines.str();
+    }
+
+    uint32_t NextPowerOfTwo(
+        const uint32_t value)
+    {
+        uint32_t power = 1;
+        while (power < value)
+        {
+            power <<= 1;
+        }
+        return power;
+    }
+
+    bool ComputePipeline::ComputeSupported() const
+    {
+#if defined(EMSCRIPTEN)
+        return false;
+#else
+        static std::optional<bool> supported;
+
+        if (!supported.has_value())
+        {
+            GLint major_version = 0;
+            GLint minor_version = 0;
+
+            glGetIntegerv(
+                GL_MAJOR_VERSION,
+                &major_version);
+
+            glGetIntegerv(
+                GL_MINOR_VERSION,
+                &minor_version);
+
+            supported =
+                major_version > 3 ||
+                (major_version == 3 && minor_version >= 1);
+        }
+
+        return supported.value();
+#endif
+    }
+
+    WorkgroupSize ComputePipeline::SelectWorkgroupSize(
+        const uint32_t width,
+        const uint32_t height) const
+    {
+        uint32_t max_invocations = preferred_invocations;
+        uint32_t max_x = preferred_invocations;
+        uint32_t max_y = preferred_invocations;
+
+#if !defined(EMSCRIPTEN)
+        if (ComputeSupported())
+        {
+            GLint limit = 0;
+
+            glGetIntegerv(
+                GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS,
+                &limit);
+            max_invocations = std::min(
+                max_invocations,
+                static_cast<uint32_t>(limit));
+
+            glGetIntegeri_v(
+                GL_MAX_COMPUTE_WORK_GROUP_SIZE,
+                0,
+                &limit);
+            max_x = std::min(
+                max_x,
+                static_cast<uint32_t>(limit));
+
+            glGetIntegeri_v(
+                GL_MAX_COMPUTE_WORK_GROUP_SIZE,
+                1,
+                &limit);
+            max_y = std::min(
+                max_y,
+                static_cast<uint32_t>(limit));
+        }
+#endif
+
+        // Square groups for images, a short target dimension gives its
+        // invocations to the other so thin LUTs don't idle most lanes.
+        WorkgroupSize size;
+
+        size.y = std::min({
+            NextPowerOfTwo(std::max(height, 1u)),
+            max_y,
+            8u });
+
+        size.x = std::min({
+            NextPowerOfTwo(std::max(width, 1u)),
+            max_x,
+            std::max(max_invocations / size.y, 1u) });
+
+        return size;
+    }
+
+    void ComputePipeline::Dispatch(
+        Shader& shader,
+        const WorkgroupSize& workgroup_size,
+        const uint32_t width,
+        const uint32_t height,
+        const uint64_t variant)
+    {
+        shader.Bind(0, variant);
+
+#if !defined(EMSCRIPTEN)
+        glDispatchCompute(
+            (width + workgroup_size.x - 1) / workgroup_size.x,
+            (height + workgroup_size.y - 1) / workgroup_size.y,
+            1);
+#endif
+    }
+
+    void ComputePipeline::Barrier(
+        const GLbitfield barriers)
+    {
+#if !defined(EMSCRIPTEN)
+        glMemoryBarrier(
+            barriers);
+#endif
+    }
+}
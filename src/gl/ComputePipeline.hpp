@@ -0,0 +1,45 @@
+#pragma once
+
+#include "OpenGL.hpp"
+#include "Shader.hpp"
+
+#include <string>
+
+namespace GL
+{
+    struct WorkgroupSize
+    {
+        uint32_t x = 8;
+        uint32_t y = 8;
+
+        // WORKGROUP_SIZE_X/Y for the local_size layout of the shader
+        std::string Defines() const;
+    };
+
+    // Dispatch side of compute shaders, used next to Pipeline by pipelines
+    // with passes that don't need the rasteriser. Needs GLES 3.1, passes
+    // should fall back to DrawQuad when ComputeSupported is false.
+    class ComputePipeline
+    {
+    protected:
+        bool ComputeSupported() const;
+
+        // Picks a size within the device limits that covers the target
+        // with little overhang, 8x8 for images and 64x1 for 1D LUTs.
+        WorkgroupSize SelectWorkgroupSize(
+            const uint32_t width,
+            const uint32_t height) const;
+
+        void Dispatch(
+            Shader& shader,
+            const WorkgroupSize& workgroup_size,
+            const uint32_t width,
+            const uint32_t height,
+            const uint64_t variant = Shader::base_variant);
+
+        // Makes image and buffer writes visible to the stages in barriers,
+        // e.g. GL_TEXTURE_FETCH_BARRIER_BIT before sampling the result.
+        void Barrier(
+            const GLbitfield barriers);
+    };
+}
@@ -44,7 +44,7 @@ namespace GL
     }
 
     void Descriptor::SetSampler2D(
-        std::string name,
+        const UniformId name,
         Texture2DResource& texture,
         Filter min_filter,
         Filter mag_filter,
@@ -55,18 +55,20 @@ namespace GL
         auto gl_texture = static_cast<GLTextureResource&>(
             texture);
 
-        sampler2Ds[name] = {
-            gl_texture.gl_texture_handle,
-            filter_gl_enum(min_filter),
-            filter_gl_enum(mag_filter),
-            wrap_gl_enum(wrap_s),
-            wrap_gl_enum(wrap_t),
-            wrap_gl_enum(wrap_r)
-        };
+        sampler2Ds.Set(
+            name,
+            {
+                gl_texture.gl_texture_handle,
+                filter_gl_enum(min_filter),
+                filter_gl_enum(mag_filter),
+                wrap_gl_enum(wrap_s),
+                wrap_gl_enum(wrap_t),
+                wrap_gl_enum(wrap_r)
+            });
     }
 
     void Descriptor::SetSampler2DArray(
-        std::string name,
+        const UniformId name,
         Texture2DResource& texture,
         Filter min_filter,
         Filter mag_filter,
@@ -77,37 +79,78 @@ namespace GL
         auto gl_texture = static_cast<GLTextureResource&>(
             texture);
 
-        sampler2D_arrays[name] = {
-            gl_texture.gl_texture_handle,
-            filter_gl_enum(min_filter),
-            filter_gl_enum(mag_filter),
-            wrap_gl_enum(wrap_s),
-            wrap_gl_enum(wrap_t),
-            wrap_gl_enum(wrap_r)
-        };
+        sampler2D_arrays.Set(
+            name,
+            {
+                gl_texture.gl_texture_handle,
+                filter_gl_enum(min_filter),
+                filter_gl_enum(mag_filter),
+                wrap_gl_enum(wrap_s),
+                wrap_gl_enum(wrap_t),
+                wrap_gl_enum(wrap_r)
+            });
+    }
+
+    void Descriptor::SetImage2D(
+        const UniformId name,
+        Texture2DResource& texture,
+        Access access,
+        GLint level)
+    {
+        auto gl_texture = static_cast<GLTextureResource&>(
+            texture);
+
+        image2Ds.Set(
+            name,
+            {
+                gl_texture.gl_texture_handle,
+                level,
+                access
+            });
     }
 
     void Descriptor::SetUniformBlock(
-        std::string name,
+        const UniformId name,
         BufferResource& uniform_block)
     {
-        auto gl_uniform_block = static_cast<GLBufferResource&>(
+        auto& gl_uniform_block = static_cast<GLBufferResource&>(
             uniform_block);
 
-        uniform_blocks[name] = gl_uniform_block.gl_buffer_handle;
+        uniform_blocks.Set(
+            name,
+            {
+                gl_uniform_block.gl_buffer_handle,
+                gl_uniform_block.layout
+            });
+    }
+
+    void Descriptor::SetStorageBuffer(
+        const UniformId name,
+        BufferResource& storage_buffer)
+    {
+        auto gl_storage_buffer = static_cast<GLBufferResource&>(
+            storage_buffer);
+
+        storage_buffers.Set(
+            name,
+            gl_storage_buffer.gl_buffer_handle);
     }
 
     void Descriptor::SetUniformMat4(
-        std::string name,
+        const UniformId name,
         glm::mat4* mat4)
     {
-        uniform_mat4s[name] = mat4;
+        uniform_mat4s.Set(
+            name,
+            mat4);
     }
 
     void Descriptor::SetUniformFloat(
-        std::string name,
+        const UniformId name,
         float* value)
     {
-        uniform_floats[name] = value;
+        uniform_floats.Set(
+            name,
+            value);
     }
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 #include "OpenGL.hpp"
 #include "Texture2D.hpp"
+#include "UniformId.hpp"
 
 #include "../Graphics.hpp"
 #include "../properties/Property.hpp"
@@ -23,6 +24,20 @@ namespace GL
         GLint wrap_r;
     };
 
+    // The image format comes from the shader's layout qualifier
+    struct ImageDescriptor
+    {
+        GLuint handle;
+        GLint level;
+        Access access;
+    };
+
+    struct UniformBlockDescriptor
+    {
+        GLuint handle;
+        const UniformLayout* layout;
+    };
+
     class Shader;
 
     class Descriptor
@@ -30,15 +45,17 @@ namespace GL
         friend class Shader;
 
     private:
-        std::map<std::string, SamplerDescriptor> sampler2Ds;
-        std::map<std::string, SamplerDescriptor> sampler2D_arrays;
-        std::map<std::string, GLuint> uniform_blocks;
-        std::map<std::string, glm::mat4*> uniform_mat4s;
-        std::map<std::string, float*> uniform_floats;
+        UniformTable<SamplerDescriptor> sampler2Ds;
+        UniformTable<SamplerDescriptor> sampler2D_arrays;
+        UniformTable<ImageDescriptor> image2Ds;
+        UniformTable<UniformBlockDescriptor> uniform_blocks;
+        UniformTable<GLuint> storage_buffers;
+        UniformTable<glm::mat4*> uniform_mat4s;
+        UniformTable<float*> uniform_floats;
 
     public:
         void SetSampler2D(
-            std::string name,
+            const UniformId name,
             Texture2DResource& texture,
             Filter min_filter,
             Filter mag_filter,
@@ -47,7 +64,7 @@ namespace GL
             Wrap wrap_r = Wrap::REPEAT);
 
         void SetSampler2DArray(
-            std::string name,
+            const UniformId name,
             Texture2DResource& texture,
             Filter min_filter,
             Filter mag_filter,
@@ -55,16 +72,30 @@ namespace GL
             Wrap wrap_t,
             Wrap wrap_r = Wrap::REPEAT);
 
+        // Image units are the binding declared in the shader, the texture
+        // must have immutable storage
+        void SetImage2D(
+            const UniformId name,
+            Texture2DResource& texture,
+            Access access,
+            GLint level = 0);
+
         void SetUniformBlock(
-            std::string name,
+            const UniformId name,
             BufferResource& uniform_block);
 
+        // Storage blocks bind at the binding declared in the shader,
+        // GLES has no API to reassign it
+        void SetStorageBuffer(
+            const UniformId name,
+            BufferResource& storage_buffer);
+
         void SetUniformMat4(
-            std::string name,
+            const UniformId name,
             glm::mat4* mat4);
 
         void SetUniformFloat(
-            std::string name,
+            const UniformId name,
             float* value);
     };
 }
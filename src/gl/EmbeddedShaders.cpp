@@ -0,0 +1,22 @@
+#include "EmbeddedShaders.hpp"
+
+namespace GL
+{
+    namespace EmbeddedShaders
+    {
+        const Entry* Find(
+            const std::string& path)
+        {
+#if defined(SHADERS_EMBEDDED)
+            for (size_t i = 0; i < entry_count; i++)
+            {
+                if (entries[i].path == path)
+                {
+                    return &entries[i];
+                }
+            }
+#endif
+            return nullptr;
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Parser.hpp"
+
+#include <string>
+#include <cstddef>
+#include <string_view>
+
+namespace GL
+{
+    // Shader sources expanded and reflected at build time by
+    // tools/ShaderEmbed.cpp, see EMBED_SHADERS in CMakeLists.txt. Shaders
+    // found here load without file access or parsing, hot reload still
+    // reads from disk.
+    namespace EmbeddedShaders
+    {
+        struct Entry
+        {
+            std::string_view path;
+            std::string_view source;
+            const std::string_view* dependencies;
+            size_t dependency_count;
+            Parser (*reflection)();
+        };
+
+        // Defined by the generated EmbeddedShaderData.cpp
+        extern const Entry entries[];
+        extern const size_t entry_count;
+
+        // nullptr when the shader was not embedded
+        const Entry* Find(
+            const std::string& path);
+    }
+}
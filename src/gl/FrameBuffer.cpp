@@ -1,5 +1,10 @@
 #include "FrameBuffer.hpp"
 
+#include "State.hpp"
+
+#include <cmath>
+#include <algorithm>
+
 namespace GL
 {
     template <typename T>
@@ -19,28 +24,28 @@ namespace GL
             1,
             &gl_frame_handle);
 
-        glBindFramebuffer(
-            GL_FRAMEBUFFER,
+        State::BindFramebuffer(
             gl_frame_handle);
 
         glGenTextures(
             1,
             &gl_texture_handle);
 
-        glBindTexture(
+        State::BindTexture(
             GL_TEXTURE_2D,
             gl_texture_handle);
 
-        glTexImage2D(
+        // Immutable storage so compute passes can bind it as an image
+        const GLsizei levels = mipmaps ?
+            1 + static_cast<GLsizei>(std::log2(std::max(width, height))) :
+            1;
+
+        glTexStorage2D(
             GL_TEXTURE_2D,
-            mipmaps ? 0 : 1,
+            levels,
             gl_internal_format,
             width,
-            height,
-            0,
-            gl_format,
-            gl_type,
-            0);
+            height);
 
         glGenRenderbuffers(
             1,
@@ -85,8 +90,7 @@ namespace GL
             assert(false);
         }
 
-        glBindFramebuffer(
-            GL_FRAMEBUFFER,
+        State::BindFramebuffer(
             0);
     }
 
@@ -101,11 +105,11 @@ namespace GL
     {
         if (created)
         {
-            glDeleteFramebuffers(
-                1, &gl_frame_handle);
+            State::DeleteFramebuffer(
+                gl_frame_handle);
 
-            glDeleteTextures(
-                1, &gl_texture_handle);
+            State::DeleteTexture(
+                gl_texture_handle);
 
             glDeleteRenderbuffers(
                 1, &gl_depth_renderbuffer_handle);
@@ -117,11 +121,10 @@ namespace GL
     template <typename T>
     void FrameBuffer<T>::Bind()
     {
-        glBindFramebuffer(
-            GL_FRAMEBUFFER,
+        State::BindFramebuffer(
             gl_frame_handle);
 
-        glViewport(
+        State::Viewport(
             0, 0,
             width,
             height);
@@ -130,7 +133,7 @@ namespace GL
     template<>
     void FrameBuffer<TexDataByteRGBA>::SetFormat()
     {
-        gl_internal_format = GL_RGBA;
+        gl_internal_format = GL_RGBA8;
         gl_format = GL_RGBA;
         gl_type = GL_UNSIGNED_BYTE;
     };
@@ -1,4 +1,5 @@
 #include "ImGui.hpp"
+#include "State.hpp"
 
 #include "imgui/imgui.h"
 
@@ -89,7 +90,7 @@ void GUI::Init()
         1,
         &g_FontTexture);
 
-    glBindTexture(
+    GL::State::BindTexture(
         GL_TEXTURE_2D,
         g_FontTexture);
 
@@ -121,12 +122,17 @@ void GUI::Init()
 
 void GUI::Deinit()
 {
-    glDeleteProgram(
+    GL::State::DeleteProgram(
         gl_shader_program);
 
-    glDeleteTextures(
-        1,
-        &g_FontTexture);
+    GL::State::DeleteTexture(
+        g_FontTexture);
+
+    GL::State::DeleteBuffer(
+        g_VboHandle);
+
+    GL::State::DeleteBuffer(
+        g_ElementsHandle);
 }
 
 void GUI::Draw(
@@ -148,28 +154,31 @@ void GUI::Draw(
         -1.0f,
         1.0f);
 
-    glEnable(
+    GL::State::Enable(
         GL_BLEND);
 
-    glBlendEquation(
+    GL::State::BlendEquation(
         GL_FUNC_ADD);
 
-    glBlendFunc(
+    GL::State::BlendFunc(
         GL_SRC_ALPHA,
         GL_ONE_MINUS_SRC_ALPHA);
 
-    glDisable(
+    GL::State::Disable(
         GL_CULL_FACE);
 
-    glDisable(
+    GL::State::Disable(
         GL_DEPTH_TEST);
 
-    glEnable(
+    GL::State::Enable(
         GL_SCISSOR_TEST);
 
-    glUseProgram(
+    GL::State::UseProgram(
         gl_shader_program);
 
+    GL::State::ActiveTexture(
+        GL_TEXTURE0);
+
     glUniform1i(
         g_AttribLocationTex,
         0);
@@ -180,21 +189,21 @@ void GUI::Draw(
         GL_FALSE,
         &proj[0][0]);
 
-    glBindBuffer(
+    GL::State::BindBuffer(
         GL_ARRAY_BUFFER,
         g_VboHandle);
 
-    glBindBuffer(
+    GL::State::BindBuffer(
         GL_ELEMENT_ARRAY_BUFFER,
         g_ElementsHandle);
 
-    glEnableVertexAttribArray(
+    GL::State::EnableVertexAttribArray(
         g_AttribLocationVtxPos);
 
-    glEnableVertexAttribArray(
+    GL::State::EnableVertexAttribArray(
         g_AttribLocationVtxUV);
 
-    glEnableVertexAttribArray(
+    GL::State::EnableVertexAttribArray(
         g_AttribLocationVtxColor);
 
     glVertexAttribPointer(
@@ -263,7 +272,7 @@ void GUI::Draw(
                     (int)(clip_rect.z - clip_rect.x),
                     (int)(clip_rect.w - clip_rect.y));
 
-                glBindTexture(
+                GL::State::BindTexture(
                     GL_TEXTURE_2D,
                     (GLuint)(intptr_t)pcmd->TextureId);
 
@@ -296,6 +305,6 @@ void GUI::Draw(
         }
     }
 
-    glDisable(GL_BLEND);
-    glDisable(GL_SCISSOR_TEST);
+    GL::State::Disable(GL_BLEND);
+    GL::State::Disable(GL_SCISSOR_TEST);
 }
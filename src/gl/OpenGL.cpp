@@ -1,7 +1,18 @@
 #include "OpenGL.hpp"
+#include "State.hpp"
+#include "ProgramCache.hpp"
+#include "Preprocessor.hpp"
 
+#include "../Timing.hpp"
+
+#include <set>
 #include <assert.h>
 #include <sstream>
+#include <optional>
+
+#if !defined(EMSCRIPTEN)
+#include <EGL/egl.h>
+#endif
 
 namespace GL
 {
@@ -36,11 +47,11 @@ namespace GL
 
     void Deinit()
     {
-        glDeleteBuffers(
-            1, &quad_vertex_buffer);
+        State::DeleteBuffer(
+            quad_vertex_buffer);
 
-        glDeleteBuffers(
-            1, &quad_index_buffer);
+        State::DeleteBuffer(
+            quad_index_buffer);
     }
 
     GLuint LoadShader(
@@ -70,12 +81,73 @@ namespace GL
         std::stringstream shader;
         shader << header;
         shader << defines << std::endl;
-        shader << "#line 2" << std::endl;
+        shader << "#line 2 0" << std::endl;
         shader << body;
         return shader.str();
     }
 
-    GLuint LinkShaderFile(
+    bool HasExtension(
+        const std::string& name)
+    {
+        static std::optional<std::set<std::string>> extensions;
+
+        if (!extensions.has_value())
+        {
+            extensions.emplace();
+
+            GLint num_extensions = 0;
+            glGetIntegerv(
+                GL_NUM_EXTENSIONS,
+                &num_extensions);
+
+            for (GLint i = 0; i < num_extensions; i++)
+            {
+                const char* extension = reinterpret_cast<const char*>(
+                    glGetStringi(GL_EXTENSIONS, i));
+
+                if (extension != nullptr)
+                {
+                    extensions->insert(extension);
+                }
+            }
+        }
+
+        return extensions->count(name) > 0;
+    }
+
+    bool ParallelCompileSupported()
+    {
+        static std::optional<bool> supported;
+
+        if (supported.has_value())
+        {
+            return supported.value();
+        }
+
+        supported = false;
+
+#if !defined(EMSCRIPTEN)
+        supported = HasExtension(
+            "GL_KHR_parallel_shader_compile");
+
+        if (supported.value())
+        {
+            const auto max_compiler_threads =
+                reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(
+                    eglGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+
+            if (max_compiler_threads != nullptr)
+            {
+                // Let the driver pick the thread count
+                max_compiler_threads(0xFFFFFFFF);
+            }
+        }
+#endif
+
+        return supported.value();
+    }
+
+    ProgramBuild SubmitShaderFile(
         const std::string shader_string,
         const std::string defines)
     {
@@ -95,76 +167,350 @@ namespace GL
             shader_string,
             fragment_defines.str());
 
-        return LinkShader(
+        return SubmitShader(
             vertex_shader_string,
             fragment_shader_string);
     }
 
-    GLuint LinkShader(
+    bool LoadCachedBuild(
+        ProgramBuild& build,
+        hrc::time_point& submit_time)
+    {
+        build.program = ProgramCache::Load(
+            build.cache_key);
+
+        if (build.program == 0)
+        {
+            return false;
+        }
+
+        build.finished = true;
+
+        ProgramCache::AddLinkTime(
+            timer_end(submit_time));
+
+        return true;
+    }
+
+    void LinkBuild(
+        ProgramBuild& build,
+        hrc::time_point& submit_time)
+    {
+        build.program = glCreateProgram();
+
+        if (build.program == 0)
+        {
+            throw std::runtime_error(
+                "shader init error");
+        }
+
+        for (const GLuint shader : {
+            build.vertex_shader,
+            build.fragment_shader,
+            build.compute_shader })
+        {
+            if (shader != 0)
+            {
+                glAttachShader(
+                    build.program,
+                    shader);
+            }
+        }
+
+        if (ProgramCache::Enabled())
+        {
+            glProgramParameteri(
+                build.program,
+                GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                GL_TRUE);
+        }
+
+        // Status is not queried here, that would wait for the driver
+        glLinkProgram(
+            build.program);
+
+        ProgramCache::AddLinkTime(
+            timer_end(submit_time));
+    }
+
+    ProgramBuild SubmitShader(
         const std::string vertex_shader_string,
         const std::string fragment_shader_string)
     {
-        const GLuint vertex_shader = LoadShader(
+        auto submit_time = timer_start();
+
+        ProgramBuild build;
+
+        build.cache_key = ProgramCache::Key(
+            vertex_shader_string,
+            fragment_shader_string);
+
+        if (LoadCachedBuild(build, submit_time))
+        {
+            return build;
+        }
+
+        ParallelCompileSupported();
+
+        build.vertex_shader = LoadShader(
             GL_VERTEX_SHADER,
             vertex_shader_string.c_str());
 
-        const GLuint fragment_shader = LoadShader(
+        build.fragment_shader = LoadShader(
             GL_FRAGMENT_SHADER,
             fragment_shader_string.c_str());
 
-        const GLuint program_object = glCreateProgram();
+        LinkBuild(
+            build,
+            submit_time);
+
+        return build;
+    }
+
+    ProgramBuild SubmitComputeShaderFile(
+        const std::string shader_string,
+        const std::string defines)
+    {
+        std::stringstream compute_defines;
+        compute_defines << "#define COMPILING_CS" << std::endl;
+        compute_defines << defines << std::endl;
+
+        return SubmitComputeShader(
+            InsertDefines(
+                shader_string,
+                compute_defines.str()));
+    }
 
-        if (program_object == 0)
+    ProgramBuild SubmitComputeShader(
+        const std::string compute_shader_string)
+    {
+#if defined(EMSCRIPTEN)
+        throw std::runtime_error(
+            "compute shaders are not supported by WebGL2");
+#else
+        auto submit_time = timer_start();
+
+        ProgramBuild build;
+
+        build.cache_key = ProgramCache::Key(
+            compute_shader_string,
+            "");
+
+        if (LoadCachedBuild(build, submit_time))
         {
-            throw std::runtime_error(
-                "shader init error");
+            return build;
         }
 
-        glAttachShader(
-            program_object,
-            vertex_shader);
+        ParallelCompileSupported();
 
-        glAttachShader(
-            program_object,
-            fragment_shader);
+        build.compute_shader = LoadShader(
+            GL_COMPUTE_SHADER,
+            compute_shader_string.c_str());
 
-        glLinkProgram(
-            program_object);
+        LinkBuild(
+            build,
+            submit_time);
+
+        return build;
+#endif
+    }
+
+    bool ProgramBuildComplete(
+        const ProgramBuild& build)
+    {
+        if (build.finished || !ParallelCompileSupported())
+        {
+            return true;
+        }
+
+        GLint complete = GL_FALSE;
+
+        glGetProgramiv(
+            build.program,
+            GL_COMPLETION_STATUS_KHR,
+            &complete);
+
+        return complete == GL_TRUE;
+    }
+
+    void PrintShaderLog(
+        const GLuint shader)
+    {
+        if (shader == 0)
+        {
+            return;
+        }
+
+        GLint compiled = GL_FALSE;
 
-        GLint linked;
+        glGetShaderiv(
+            shader,
+            GL_COMPILE_STATUS,
+            &compiled);
+
+        if (compiled)
+        {
+            return;
+        }
+
+        GLint info_len = 0;
+        glGetShaderiv(
+            shader,
+            GL_INFO_LOG_LENGTH,
+            &info_len);
+
+        if (info_len > 1)
+        {
+            std::vector<char> info_log(info_len);
+            glGetShaderInfoLog(
+                shader,
+                info_len,
+                NULL,
+                info_log.data());
+            std::cout << "compile error " << info_log.data() << std::endl;
+            std::cout << "source strings" << std::endl <<
+                Preprocessor::SourceTable();
+        }
+    }
+
+    void DeleteBuildShaders(
+        ProgramBuild& build)
+    {
+        if (build.vertex_shader != 0)
+        {
+            glDeleteShader(
+                build.vertex_shader);
+        }
+
+        if (build.fragment_shader != 0)
+        {
+            glDeleteShader(
+                build.fragment_shader);
+        }
+
+        if (build.compute_shader != 0)
+        {
+            glDeleteShader(
+                build.compute_shader);
+        }
+
+        build.vertex_shader = 0;
+        build.fragment_shader = 0;
+        build.compute_shader = 0;
+    }
+
+    GLuint FinishProgram(
+        ProgramBuild& build)
+    {
+        if (build.finished)
+        {
+            return build.program;
+        }
+
+        auto finish_time = timer_start();
+
+        GLint linked = GL_FALSE;
 
         glGetProgramiv(
-            program_object,
+            build.program,
             GL_LINK_STATUS,
             &linked);
 
         if (!linked)
         {
+            PrintShaderLog(
+                build.vertex_shader);
+
+            PrintShaderLog(
+                build.fragment_shader);
+
+            PrintShaderLog(
+                build.compute_shader);
+
             GLint info_len = 0;
             glGetProgramiv(
-                program_object,
+                build.program,
                 GL_INFO_LOG_LENGTH,
                 &info_len);
 
             if (info_len > 1)
             {
-                char* info_log = new char[sizeof(char) * info_len];
+                std::vector<char> info_log(info_len);
                 glGetProgramInfoLog(
-                    program_object,
+                    build.program,
                     info_len,
                     NULL,
-                    info_log);
-                std::cout << "link error " << info_log << std::endl;
-                free(info_log);
+                    info_log.data());
+                std::cout << "link error " << info_log.data() << std::endl;
             }
 
+            DeleteBuildShaders(
+                build);
+
             glDeleteProgram(
-                program_object);
+                build.program);
+
+            build.program = 0;
+
             throw std::runtime_error(
                 "shader init error");
         }
 
-        return program_object;
+        DeleteBuildShaders(
+            build);
+
+        if (build.cacheable)
+        {
+            ProgramCache::Store(
+                build.cache_key,
+                build.program);
+        }
+
+        ProgramCache::AddLinkTime(
+            timer_end(finish_time));
+
+        build.finished = true;
+
+        return build.program;
+    }
+
+    void DeleteProgramBuild(
+        ProgramBuild& build)
+    {
+        DeleteBuildShaders(
+            build);
+
+        if (build.program != 0)
+        {
+            State::DeleteProgram(
+                build.program);
+        }
+
+        build = ProgramBuild();
+    }
+
+    GLuint LinkShaderFile(
+        const std::string shader_string,
+        const std::string defines)
+    {
+        ProgramBuild build = SubmitShaderFile(
+            shader_string,
+            defines);
+
+        return FinishProgram(
+            build);
+    }
+
+    GLuint LinkShader(
+        const std::string vertex_shader_string,
+        const std::string fragment_shader_string)
+    {
+        ProgramBuild build = SubmitShader(
+            vertex_shader_string,
+            fragment_shader_string);
+
+        return FinishProgram(
+            build);
     }
 
     GLuint LoadShader(
@@ -174,7 +520,10 @@ namespace GL
         const GLuint shader = glCreateShader(type);
 
         if (shader == 0)
-            return 0;
+        {
+            throw std::runtime_error(
+                "shader init error");
+        }
 
         glShaderSource(
             shader,
@@ -182,42 +531,9 @@ namespace GL
             &shader_src,
             NULL);
 
-        GLint compiled;
-
         glCompileShader(
             shader);
 
-        glGetShaderiv(
-            shader,
-            GL_COMPILE_STATUS,
-            &compiled);
-
-        if (!compiled)
-        {
-            GLint info_len = 0;
-            glGetShaderiv(
-                shader,
-                GL_INFO_LOG_LENGTH,
-                &info_len);
-
-            if (info_len > 1)
-            {
-                char* info_log = new char[sizeof(char) * info_len];
-                glGetShaderInfoLog(
-                    shader,
-                    info_len,
-                    NULL,
-                    info_log);
-                std::cout << shader_src << std::endl;
-                std::cout << "compile error " << info_log << std::endl;
-            }
-
-            glDeleteShader(
-                shader);
-            throw std::runtime_error(
-                "shader init error");
-        }
-
         return shader;
     }
 
@@ -231,7 +547,7 @@ namespace GL
             1,
             &gl_buffer_handle);
 
-        glBindBuffer(
+        State::BindBuffer(
             gl_target,
             gl_buffer_handle);
 
@@ -241,7 +557,7 @@ namespace GL
             &(data)[0],
             GL_STATIC_DRAW);
 
-        glBindBuffer(
+        State::BindBuffer(
             gl_target,
             NULL);
 
@@ -258,7 +574,7 @@ namespace GL
             1,
             &gl_buffer_handle);
 
-        glBindBuffer(
+        State::BindBuffer(
             gl_target,
             gl_buffer_handle);
 
@@ -268,7 +584,7 @@ namespace GL
             &(data)[0],
             GL_STATIC_DRAW);
 
-        glBindBuffer(
+        State::BindBuffer(
             gl_target,
             NULL);
 
@@ -31,14 +31,35 @@ namespace GL
         GLuint gl_texture_handle = 0;
     };
 
+    struct UniformMember
+    {
+        std::string name;
+        size_t offset;
+    };
+
+    // Byte offsets of a C++ uniform struct, listed under the GLSL member
+    // names and checked against the driver's std140 offsets at link time
+    struct UniformLayout
+    {
+        size_t size;
+        std::vector<UniformMember> members;
+    };
+
     class GLBufferResource : public BufferResource
     {
     public:
         GLuint gl_buffer_handle = 0;
+
+        // Set for uniform buffers, nullptr skips layout validation
+        const UniformLayout* layout = nullptr;
     };
 
     void CheckError();
 
+    // Names as reported by glGetStringi, queried once
+    bool HasExtension(
+        const std::string& name);
+
     extern void Init();
     extern void Deinit();
 
@@ -46,6 +67,54 @@ namespace GL
     extern GLuint quad_vertex_buffer;
     extern GLuint quad_index_buffer;
 
+    // A program whose compile and link have been submitted to the driver.
+    // Status is only queried by FinishProgram, so several builds can be in
+    // flight at once.
+    struct ProgramBuild
+    {
+        GLuint program = 0;
+        GLuint vertex_shader = 0;
+        GLuint fragment_shader = 0;
+        GLuint compute_shader = 0;
+        uint64_t cache_key = 0;
+        bool finished = false;
+
+        // Cleared for one-off define sets, FinishProgram then leaves the
+        // binary out of the program cache
+        bool cacheable = true;
+    };
+
+    ProgramBuild SubmitShaderFile(
+        const std::string shader_string,
+        const std::string defines = "");
+
+    ProgramBuild SubmitShader(
+        const std::string vertex_shader_string,
+        const std::string fragment_shader_string);
+
+    // Compute programs need GLES 3.1, this throws on WebGL2
+    ProgramBuild SubmitComputeShaderFile(
+        const std::string shader_string,
+        const std::string defines = "");
+
+    ProgramBuild SubmitComputeShader(
+        const std::string compute_shader_string);
+
+    // KHR_parallel_shader_compile, never on WebGL
+    bool ParallelCompileSupported();
+
+    // Non-blocking when KHR_parallel_shader_compile is available,
+    // otherwise always true and FinishProgram blocks.
+    bool ProgramBuildComplete(
+        const ProgramBuild& build);
+
+    GLuint FinishProgram(
+        ProgramBuild& build);
+
+    // Releases a build whether or not it was finished
+    void DeleteProgramBuild(
+        ProgramBuild& build);
+
     GLuint LinkShaderFile(
         const std::string shader_string,
         const std::string defines = "");
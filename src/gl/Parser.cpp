@@ -1,6 +1,9 @@
 #include "Parser.hpp"
 
-#include <set>
+#include "../Hash.hpp"
+
+#include <array>
+#include <cstring>
 #include <assert.h>
 #include <stdexcept>
 
@@ -14,10 +17,10 @@ enum class ParseMode
     UNIFORM_BLOCK,
     UNIFORM_BLOCK_MEMBERS,
     BUFFER,
-    BUFFER_META,
+    BUFFER_MEMBERS,
 };
 
-const std::set<std::string> keywords = {
+constexpr std::array<std::string_view, 27> keyword_list = {
     "float",
     "vec2",
     "vec3",
@@ -47,33 +50,158 @@ const std::set<std::string> keywords = {
     ";",
 };
 
+// Perfect hash over keyword_list. The seed is searched at compile time
+// until every keyword lands in its own slot, so a lookup is one hash and
+// one compare. FNV alone barely separates one character keywords in its
+// high bits, so the hash is finalised before taking the slot.
+constexpr uint32_t keyword_slot_bits = 7;
+constexpr size_t keyword_slots = size_t(1) << keyword_slot_bits;
+
+struct KeywordTable
+{
+    uint64_t seed = 0;
+    std::array<std::string_view, keyword_slots> slots = {};
+};
+
+constexpr size_t KeywordSlot(
+    const std::string_view word,
+    const uint64_t seed)
+{
+    uint64_t hash = hash_fnv1a(word, seed);
+    hash ^= hash >> 32;
+    hash *= 0x9E3779B97F4A7C15ull;
+
+    return static_cast<size_t>(
+        hash >> (64 - keyword_slot_bits));
+}
+
+constexpr KeywordTable BuildKeywordTable()
+{
+    KeywordTable table;
+
+    for (uint64_t seed = fnv_offset_basis;; seed++)
+    {
+        bool collision = false;
+        table.slots = {};
+
+        for (const std::string_view keyword : keyword_list)
+        {
+            std::string_view& slot = table.slots[
+                KeywordSlot(keyword, seed)];
+
+            if (!slot.empty())
+            {
+                collision = true;
+                break;
+            }
+
+            slot = keyword;
+        }
+
+        if (!collision)
+        {
+            table.seed = seed;
+            return table;
+        }
+    }
+}
+
+constexpr KeywordTable keywords = BuildKeywordTable();
+
+constexpr bool IsKeyword(
+    const std::string_view word)
+{
+    return
+        !word.empty() &&
+        keywords.slots[KeywordSlot(word, keywords.seed)] == word;
+}
+
+static_assert(IsKeyword("sampler2DArray"));
+static_assert(!IsKeyword("atmosphere"));
+
+constexpr std::array<std::string_view, 13> image_formats = {
+    "rgba32f",
+    "rgba16f",
+    "r32f",
+    "rgba8",
+    "rgba8_snorm",
+    "rgba32i",
+    "rgba16i",
+    "rgba8i",
+    "r32i",
+    "rgba32ui",
+    "rgba16ui",
+    "rgba8ui",
+    "r32ui",
+};
+
+constexpr bool IsImageFormat(
+    const std::string_view word)
+{
+    for (const std::string_view format : image_formats)
+    {
+        if (format == word)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 struct State
 {
     std::string name = "";
     std::string type = "";
     std::string shader_block_name = "";
     std::string shader_block_type = "";
+    std::string uniform_type = "";
+    std::string image_format = "";
     std::vector<TypePair> uniform_list;
 };
 
 Parser::Parser(
-    const ShaderParseType parse_type,
-    const std::string program)
+    const std::string_view program)
+{
+    Parse(program);
+}
+
+const StageReflection& Parser::Stage(
+    const ShaderParseType parse_type) const
 {
-    Parse(parse_type, program);
+    static const StageReflection missing_stages[] = {
+        { ShaderParseType::VERTEX },
+        { ShaderParseType::FRAGMENT },
+        { ShaderParseType::COMPUTE }
+    };
+
+    for (const auto& stage : stages)
+    {
+        if (stage.stage == parse_type)
+        {
+            return stage;
+        }
+    }
+
+    return missing_stages[static_cast<size_t>(parse_type)];
 }
 
 void Parser::Parse(
-    const ShaderParseType parse_type,
-    const std::string program)
+    const std::string_view program)
 {
-    const std::vector<Token> tokens = tokenize(program);
+    TokenArena arena;
+
+    const std::vector<Token>& tokens = tokenize(
+        program,
+        arena);
+
     const size_t num_tokens = tokens.size();
 
     Token token;
     State state;
     ParseMode mode = ParseMode::INIT;
     std::vector<ParseMode> mode_stack;
+    StageReflection* stage = nullptr;
 
     size_t position = 0;
     size_t num_remaining = num_tokens;
@@ -92,6 +220,8 @@ void Parser::Parse(
         state.name = "";
         state.shader_block_name = "";
         state.type = "";
+        state.uniform_type = "";
+        state.image_format = "";
         state.uniform_list.clear();
         mode = new_state;
     };
@@ -103,9 +233,9 @@ void Parser::Parse(
 
     const auto CheckName = [&]() {
         state.name = "";
-        if (token.type != "name")
+        if (token.type != TokenKind::NAME)
             return;
-        if (keywords.find(token.value) != keywords.end())
+        if (IsKeyword(token.value))
             return;
         state.name = token.value;
     };
@@ -126,41 +256,81 @@ void Parser::Parse(
 
     Step(0);
 
+    const auto BeginStage = [&](const ShaderParseType parse_type) {
+        stages.push_back({ parse_type });
+        stage = &stages.back();
+        mode_stack.clear();
+        ClearState();
+    };
+
+    // Members are "type name;", array members record their type with [],
+    // so a runtime sized "Sphere spheres[];" reads as "Sphere[]".
+    const auto BlockMember = [&](std::vector<UniformBlock>& blocks) {
+        if (token.value == "}")
+        {
+            blocks.push_back({
+                state.shader_block_type,
+                state.shader_block_name,
+                state.uniform_list
+            });
+
+            ClearState();
+        }
+        else if (token.value == ";")
+        {
+            state.uniform_list.push_back({
+                state.type,
+                state.name
+            });
+
+            ClearUniformBlockState();
+        }
+        else if (token.value == "[")
+        {
+            state.type += "[]";
+        }
+        else if (token.type != TokenKind::NAME)
+        {
+            return;
+        }
+        else if (state.type == "")
+        {
+            state.type = token.value;
+        }
+        else
+        {
+            state.name = token.value;
+        }
+    };
+
     while (num_remaining > 0)
     {
+        // A section marker ends the previous stage in any mode
+        if (token.value == "COMPILING_VS")
+        {
+            BeginStage(ShaderParseType::VERTEX);
+            Step();
+            continue;
+        }
+        else if (token.value == "COMPILING_FS")
+        {
+            BeginStage(ShaderParseType::FRAGMENT);
+            Step();
+            continue;
+        }
+        else if (token.value == "COMPILING_CS")
+        {
+            BeginStage(ShaderParseType::COMPUTE);
+            Step();
+            continue;
+        }
+
         switch (mode)
         {
         case ParseMode::INIT:
-            if (parse_type == ShaderParseType::VERTEX)
-            {
-                if (token.value == "COMPILING_VS")
-                {
-                    mode = ParseMode::NONE;
-                }
-            }
-            else if (parse_type == ShaderParseType::FRAGMENT)
-            {
-                if (token.value == "COMPILING_FS")
-                {
-                    mode = ParseMode::NONE;
-                }
-            }
-            else if (parse_type == ShaderParseType::COMPUTE)
-            {
-                if (token.value == "COMPILING_CS")
-                {
-                    mode = ParseMode::NONE;
-                }
-            }
             break;
 
         case ParseMode::NONE:
-            if (token.value == "COMPILING_VS" ||
-                token.value == "COMPILING_FS" ||
-                token.value == "COMPILING_CS")
-            {
-                return;
-            }
             if (token.value == "in")
             {
                 PushParseMode(ParseMode::ATTRIBUTE);
@@ -196,6 +366,10 @@ void Parser::Parse(
             {
                 state.type = token.value;
             }
+            else if (IsImageFormat(token.value))
+            {
+                state.image_format = token.value;
+            }
             else if (token.value == ";")
             {
                 ClearState();
@@ -205,7 +379,7 @@ void Parser::Parse(
         case ParseMode::ATTRIBUTE:
             if (token.value == ";")
             {
-                attributes.push_back({
+                stage->attributes.push_back({
                     state.type,
                     state.name
                 });
@@ -226,28 +400,28 @@ void Parser::Parse(
             {
                 if (state.type == "sampler2D")
                 {
-                    uniform_sampler2Ds.push_back({
+                    stage->uniform_sampler2Ds.push_back({
                         state.type,
                         state.name
                     });
                 }
                 else if (state.type == "sampler2DArray")
                 {
-                    uniform_sampler2D_arrays.push_back({
+                    stage->uniform_sampler2D_arrays.push_back({
                         state.type,
                         state.name
                     });
                 }
                 else if (state.type == "mat4")
                 {
-                    uniform_mat4s.push_back({
+                    stage->uniform_mat4s.push_back({
                         state.type,
                         state.name
                     });
                 }
                 else if (state.type == "float")
                 {
-                    uniform_floats.push_back({
+                    stage->uniform_floats.push_back({
                         state.type,
                         state.name
                     });
@@ -278,54 +452,42 @@ void Parser::Parse(
                 ClearUniformBlockState();
                 PushParseMode(ParseMode::UNIFORM_BLOCK_MEMBERS);
             }
-            else
-            {
-                CheckName();
-            }
-            break;
-
-        case ParseMode::UNIFORM_BLOCK_MEMBERS:
-            if (token.value == "}")
-            {
-                uniform_blocks.push_back({
-                    state.shader_block_type,
-                    state.shader_block_name,
-                    state.uniform_list
-                });
-
-                ClearState();
-            }
             else if (token.value == ";")
             {
-                state.uniform_list.push_back({
-                    state.type,
-                    state.name
-                });
+                // Not a block but a layout qualified uniform, images
+                // carry their format and binding this way
+                if (state.uniform_type == "image2D")
+                {
+                    stage->uniform_image2Ds.push_back({
+                        state.image_format,
+                        state.name
+                    });
+                }
 
-                ClearUniformBlockState();
+                ClearState();
             }
-            else if (state.type == "")
+            else if (token.value == "image2D")
             {
-                state.type = token.value;
+                state.uniform_type = token.value;
             }
             else
             {
-                state.name = token.value;
+                CheckName();
             }
             break;
 
-        case ParseMode::BUFFER:
-            if (token.value == ";")
-            {
-                throw std::runtime_error(
-                    "GLSL Buffer not supported.");
+        case ParseMode::UNIFORM_BLOCK_MEMBERS:
+            BlockMember(
+                stage->uniform_blocks);
+            break;
 
-                ClearState();
-            }
+        case ParseMode::BUFFER:
             if (token.value == "{")
             {
                 state.shader_block_name = state.name;
+                state.shader_block_type = state.type;
                 ClearUniformBlockState();
+                PushParseMode(ParseMode::BUFFER_MEMBERS);
             }
             else
             {
@@ -333,9 +495,230 @@ void Parser::Parse(
             }
             break;
 
+        case ParseMode::BUFFER_MEMBERS:
+            BlockMember(
+                stage->storage_blocks);
+            break;
+
         default:
             break;
         }
         Step();
     }
 }
+
+// Strings are uint16_t length prefixed like File::ReadStringPrefixed,
+// list sizes are uint32_t.
+class SerialWriter
+{
+public:
+    std::string output;
+
+    void Count(
+        const size_t count)
+    {
+        const uint32_t value = static_cast<uint32_t>(count);
+        output.append(
+            reinterpret_cast<const char*>(&value),
+            sizeof(value));
+    }
+
+    void String(
+        const std::string& value)
+    {
+        const uint16_t length = static_cast<uint16_t>(value.size());
+        output.append(
+            reinterpret_cast<const char*>(&length),
+            sizeof(length));
+        output.append(
+            value,
+            0,
+            length);
+    }
+
+    void Pairs(
+        const std::vector<TypePair>& pairs)
+    {
+        Count(pairs.size());
+
+        for (const auto& pair : pairs)
+        {
+            String(std::get<0>(pair));
+            String(std::get<1>(pair));
+        }
+    }
+
+    void Blocks(
+        const std::vector<UniformBlock>& blocks)
+    {
+        Count(blocks.size());
+
+        for (const auto& block : blocks)
+        {
+            String(block.type);
+            String(block.name);
+            Pairs(block.members);
+        }
+    }
+};
+
+class SerialReader
+{
+private:
+    std::string_view input;
+    size_t position = 0;
+
+    template <typename T>
+    T Value()
+    {
+        if (input.size() - position < sizeof(T))
+        {
+            throw std::runtime_error(
+                "Truncated reflection");
+        }
+
+        T value;
+        std::memcpy(
+            &value,
+            input.data() + position,
+            sizeof(T));
+
+        position += sizeof(T);
+        return value;
+    }
+
+public:
+    SerialReader(
+        const std::string_view input) :
+        input(input)
+    {
+    }
+
+    bool Done() const
+    {
+        return position == input.size();
+    }
+
+    uint32_t Count()
+    {
+        const uint32_t count = Value<uint32_t>();
+
+        // Every entry takes at least a byte, rejects absurd counts early
+        if (count > input.size() - position)
+        {
+            throw std::runtime_error(
+                "Malformed reflection");
+        }
+
+        return count;
+    }
+
+    std::string String()
+    {
+        const uint16_t length = Value<uint16_t>();
+
+        if (input.size() - position < length)
+        {
+            throw std::runtime_error(
+                "Truncated reflection");
+        }
+
+        const std::string value(
+            input.substr(position, length));
+
+        position += length;
+        return value;
+    }
+
+    std::vector<TypePair> Pairs()
+    {
+        std::vector<TypePair> pairs(Count());
+
+        for (auto& pair : pairs)
+        {
+            std::get<0>(pair) = String();
+            std::get<1>(pair) = String();
+        }
+
+        return pairs;
+    }
+
+    std::vector<UniformBlock> Blocks()
+    {
+        std::vector<UniformBlock> blocks(Count());
+
+        for (auto& block : blocks)
+        {
+            block.type = String();
+            block.name = String();
+            block.members = Pairs();
+        }
+
+        return blocks;
+    }
+};
+
+std::string Parser::Serialize() const
+{
+    SerialWriter writer;
+
+    writer.Count(stages.size());
+
+    for (const auto& stage : stages)
+    {
+        writer.Count(static_cast<size_t>(stage.stage));
+        writer.Pairs(stage.attributes);
+        writer.Pairs(stage.uniform_sampler2Ds);
+        writer.Pairs(stage.uniform_sampler2D_arrays);
+        writer.Pairs(stage.uniform_image2Ds);
+        writer.Blocks(stage.uniform_blocks);
+        writer.Blocks(stage.storage_blocks);
+        writer.Pairs(stage.uniform_mat4s);
+        writer.Pairs(stage.uniform_floats);
+    }
+
+    return writer.output;
+}
+
+std::optional<Parser> Parser::Deserialize(
+    const std::string_view data)
+{
+    SerialReader reader(data);
+    Parser parser;
+
+    try
+    {
+        parser.stages.resize(reader.Count());
+
+        for (auto& stage : parser.stages)
+        {
+            const uint32_t stage_type = reader.Count();
+
+            if (stage_type > static_cast<uint32_t>(ShaderParseType::COMPUTE))
+            {
+                return std::nullopt;
+            }
+
+            stage.stage = static_cast<ShaderParseType>(stage_type);
+            stage.attributes = reader.Pairs();
+            stage.uniform_sampler2Ds = reader.Pairs();
+            stage.uniform_sampler2D_arrays = reader.Pairs();
+            stage.uniform_image2Ds = reader.Pairs();
+            stage.uniform_blocks = reader.Blocks();
+            stage.storage_blocks = reader.Blocks();
+            stage.uniform_mat4s = reader.Pairs();
+            stage.uniform_floats = reader.Pairs();
+        }
+    }
+    catch (const std::runtime_error&)
+    {
+        return std::nullopt;
+    }
+
+    if (!reader.Done())
+    {
+        return std::nullopt;
+    }
+
+    return parser;
+}
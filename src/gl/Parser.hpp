@@ -6,6 +6,8 @@
 #include <tuple>
 #include <string>
 #include <vector>
+#include <optional>
+#include <string_view>
 
 enum class ShaderParseType
 {
@@ -23,22 +25,48 @@ struct UniformBlock
     std::vector<TypePair> members;
 };
 
+struct StageReflection
+{
+    ShaderParseType stage;
+    std::vector<TypePair> attributes;
+    std::vector<TypePair> uniform_sampler2Ds;
+    std::vector<TypePair> uniform_sampler2D_arrays;
+    // Pairs are (image format, name)
+    std::vector<TypePair> uniform_image2Ds;
+    std::vector<UniformBlock> uniform_blocks;
+    std::vector<UniformBlock> storage_blocks;
+    std::vector<TypePair> uniform_mat4s;
+    std::vector<TypePair> uniform_floats;
+};
+
+// Tokenizes the combined program once and reflects every COMPILING_*
+// section it contains in the same walk.
 class Parser
 {
 private:
     void Parse(
-        const ShaderParseType parse_type,
-        const std::string program);
+        const std::string_view program);
 
 public:
+    Parser() = default;
+
     Parser(
-        const ShaderParseType parse_type,
-        const std::string program);
+        const std::string_view program);
 
-    std::vector<TypePair> attributes;
-    std::vector<TypePair> uniform_sampler2Ds;
-    std::vector<TypePair> uniform_sampler2D_arrays;
-    std::vector<UniformBlock> uniform_blocks;
-    std::vector<TypePair> uniform_mat4s;
-    std::vector<TypePair> uniform_floats;
+    std::vector<StageReflection> stages;
+
+    // Stages missing from the source reflect as empty
+    const StageReflection& Stage(
+        const ShaderParseType parse_type) const;
+
+    // Bump whenever Serialize's layout changes, it is part of the
+    // snapshot key so records in an older layout are never read
+    static constexpr uint32_t serialization_version = 1;
+
+    // Length prefixed binary form kept in the warm-start snapshot
+    std::string Serialize() const;
+
+    // Empty when data is truncated or malformed
+    static std::optional<Parser> Deserialize(
+        const std::string_view data);
 };
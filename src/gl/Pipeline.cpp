@@ -1,14 +1,15 @@
 #include "Pipeline.hpp"
 
+#include "State.hpp"
+
 namespace GL
 {
     void Pipeline::FrontBuffer()
     {
-        glBindFramebuffer(
-            GL_FRAMEBUFFER,
+        State::BindFramebuffer(
             0);
 
-        glViewport(
+        State::Viewport(
             0,
             0,
             window_width,
@@ -24,37 +25,35 @@ namespace GL
     }
 
     void Pipeline::DrawQuad(
-        Shader& shader)
+        Shader& shader,
+        const uint64_t variant)
     {
-        glDisable(
+        State::Disable(
             GL_CULL_FACE);
 
-        glCullFace(
+        State::CullFace(
             GL_BACK);
 
-        glBindBuffer(
+        State::BindBuffer(
             GL_ARRAY_BUFFER,
             quad_vertex_buffer);
 
-        glBindBuffer(
+        State::BindBuffer(
             GL_ELEMENT_ARRAY_BUFFER,
             quad_index_buffer);
 
-        shader.Bind(0);
+        shader.Bind(0, variant);
 
         glDrawElements(
             GL_TRIANGLES,
             static_cast<GLsizei>(quad_indices_data.size()),
             GL_UNSIGNED_INT,
             static_cast<char const*>(0));
-
-        glUseProgram(
-            NULL);
     }
 
     void Pipeline::Clear()
     {
-        glClearColor(
+        State::ClearColor(
             0, 0, 0, 1);
 
         glClear(
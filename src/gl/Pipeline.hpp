@@ -5,6 +5,8 @@
 #include "OpenGL.hpp"
 #include "Shader.hpp"
 
+#include <cstddef>
+
 namespace GL
 {
     struct CameraUniforms
@@ -14,6 +16,22 @@ namespace GL
         glm::vec4 viewport;
         glm::vec4 position;
         glm::vec4 exposure;
+
+        static const UniformLayout& Layout()
+        {
+            static const UniformLayout layout = {
+                sizeof(CameraUniforms),
+                {
+                    { "view", offsetof(CameraUniforms, view) },
+                    { "projection", offsetof(CameraUniforms, projection) },
+                    { "viewport", offsetof(CameraUniforms, viewport) },
+                    { "position", offsetof(CameraUniforms, position) },
+                    { "exposure", offsetof(CameraUniforms, exposure) }
+                }
+            };
+
+            return layout;
+        }
     };
 
     class Pipeline
@@ -22,12 +40,16 @@ namespace GL
         uint32_t window_width = 0;
         uint32_t window_height = 0;
 
-        void DrawQuad(Shader& shader);
+        void DrawQuad(
+            Shader& shader,
+            const uint64_t variant = Shader::base_variant);
         void FrontBuffer();
         void Clear();
 
     public:
-        virtual void Init() = 0;
+        // Shader sources and reflection run on loader's workers
+        virtual void Init(
+            AssetLoader& loader) = 0;
 
         virtual void Deinit() = 0;
 
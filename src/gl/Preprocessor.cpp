@@ -0,0 +1,336 @@
+#include "Preprocessor.hpp"
+
+#include "../File.hpp"
+#include "../Hash.hpp"
+
+#include <set>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+#include <filesystem>
+#include <unordered_map>
+
+namespace GL
+{
+    namespace Preprocessor
+    {
+        struct Directive
+        {
+            // Span of the directive line including its newline
+            size_t begin;
+            size_t end;
+            uint32_t line;
+            std::string path;
+        };
+
+        struct Unit
+        {
+            uint64_t hash;
+            std::string text;
+            std::vector<Directive> includes;
+        };
+
+        static std::mutex mutex;
+
+        // Scanned files keyed by path and content, so an unchanged header
+        // is only scanned once however many programs include it.
+        static std::unordered_map<uint64_t, Unit> units;
+
+        // Expanded programs keyed by the contents of every file they include
+        static std::unordered_map<uint64_t, std::string> expansions;
+
+        static std::map<std::string, uint32_t> source_numbers;
+        static std::unordered_map<std::string, std::set<std::string>> dependencies;
+
+        std::string ResolvePath(
+            const std::string& including_path,
+            const std::string& include_name)
+        {
+            const std::filesystem::path path =
+                std::filesystem::path(including_path).parent_path() /
+                include_name;
+
+            return path.lexically_normal().generic_string();
+        }
+
+        std::vector<Directive> ScanIncludes(
+            const std::string& path,
+            const std::string& text)
+        {
+            std::vector<Directive> includes;
+
+            const std::string_view directive = "#include";
+
+            uint32_t line = 1;
+
+            for (size_t begin = 0; begin < text.size(); line++)
+            {
+                size_t end = text.find('\n', begin);
+                end = end == std::string::npos ? text.size() : end + 1;
+
+                size_t i = text.find_first_not_of(" \t", begin);
+
+                if (i < end && text.compare(i, directive.size(), directive) == 0)
+                {
+                    i = text.find_first_not_of(" \t", i + directive.size());
+
+                    const char open = i < end ? text[i] : '\0';
+                    const char close = open == '<' ? '>' : '"';
+                    const size_t name_end = text.find(close, i + 1);
+
+                    if ((open != '"' && open != '<') || name_end >= end)
+                    {
+                        std::stringstream error;
+                        error << path << ":" << line << ": malformed #include";
+                        throw std::runtime_error(error.str());
+                    }
+
+                    includes.push_back({
+                        begin,
+                        end,
+                        line,
+                        ResolvePath(path, text.substr(i + 1, name_end - i - 1))
+                    });
+                }
+
+                begin = end;
+            }
+
+            return includes;
+        }
+
+        const Unit& ReadUnit(
+            const std::string& path)
+        {
+            std::optional<MappedFile> file;
+
+            try
+            {
+                file.emplace(path);
+            }
+            catch (const std::exception&)
+            {
+                throw std::runtime_error(
+                    "Shader include not found: " + path);
+            }
+
+            // Hashed in place, the text is only copied for a new unit
+            const uint64_t hash = hash_fnv1a(
+                file->View(),
+                hash_fnv1a(path));
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                const auto it = units.find(hash);
+
+                if (it != units.end())
+                {
+                    return it->second;
+                }
+            }
+
+            std::string text(file->View());
+
+            std::vector<Directive> includes = ScanIncludes(
+                path,
+                text);
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            return units.emplace(
+                hash,
+                Unit { hash, std::move(text), std::move(includes) }
+                ).first->second;
+        }
+
+        uint32_t SourceNumber(
+            const std::string& path)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            // 0 is the root file, which InsertDefines leaves implicit
+            const auto it = source_numbers.emplace(
+                path,
+                static_cast<uint32_t>(source_numbers.size() + 1));
+
+            return it.first->second;
+        }
+
+        // Reads every file reachable from path in inclusion order, the key
+        // changes when any of them does.
+        void Collect(
+            const std::string& path,
+            std::map<std::string, const Unit*>& files,
+            uint64_t& key)
+        {
+            const Unit& unit = ReadUnit(path);
+
+            files[path] = &unit;
+            key = hash_fnv1a(&unit.hash, sizeof(unit.hash), key);
+
+            for (const auto& include : unit.includes)
+            {
+                if (files.find(include.path) == files.end())
+                {
+                    Collect(
+                        include.path,
+                        files,
+                        key);
+                }
+            }
+        }
+
+        void Emit(
+            const Unit& unit,
+            const uint32_t source_number,
+            const std::map<std::string, const Unit*>& files,
+            std::set<std::string>& included,
+            std::string& output)
+        {
+            size_t position = 0;
+
+            for (const auto& include : unit.includes)
+            {
+                output.append(
+                    unit.text,
+                    position,
+                    include.begin - position);
+
+                position = include.end;
+
+                if (!included.insert(include.path).second)
+                {
+                    // Keep the line so numbering past it stays right
+                    output += "\n";
+                    continue;
+                }
+
+                output += "#line 1 " +
+                    std::to_string(SourceNumber(include.path)) + "\n";
+
+                Emit(
+                    *files.at(include.path),
+                    SourceNumber(include.path),
+                    files,
+                    included,
+                    output);
+
+                if (!output.empty() && output.back() != '\n')
+                {
+                    output += "\n";
+                }
+
+                output += "#line " + std::to_string(include.line + 1) + " " +
+                    std::to_string(source_number) + "\n";
+            }
+
+            output.append(
+                unit.text,
+                position,
+                std::string::npos);
+        }
+
+        std::string Expand(
+            const std::string& file_path)
+        {
+            std::map<std::string, const Unit*> files;
+            uint64_t key = hash_fnv1a(file_path);
+
+            Collect(
+                file_path,
+                files,
+                key);
+
+            std::set<std::string> file_dependencies;
+
+            for (const auto& file : files)
+            {
+                if (file.first != file_path)
+                {
+                    file_dependencies.insert(file.first);
+                }
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+
+                dependencies[file_path] = file_dependencies;
+
+                const auto it = expansions.find(key);
+
+                if (it != expansions.end())
+                {
+                    return it->second;
+                }
+            }
+
+            const Unit& root = *files.at(file_path);
+
+            std::string output;
+            output.reserve(root.text.size());
+
+            std::set<std::string> included = { file_path };
+
+            Emit(
+                root,
+                0,
+                files,
+                included,
+                output);
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            expansions[key] = output;
+
+            return output;
+        }
+
+        bool DependsOn(
+            const std::string& file_path,
+            const std::string& dependency_path)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            const auto it = dependencies.find(file_path);
+
+            return
+                it != dependencies.end() &&
+                it->second.count(dependency_path) > 0;
+        }
+
+        std::vector<std::string> Dependencies(
+            const std::string& file_path)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            const auto it = dependencies.find(file_path);
+
+            if (it == dependencies.end())
+            {
+                return {};
+            }
+
+            return std::vector<std::string>(
+                it->second.begin(),
+                it->second.end());
+        }
+
+        std::string SourceTable()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            std::stringstream table;
+
+            for (const auto& source : source_numbers)
+            {
+                table << "  " << source.second << ": " << source.first << std::endl;
+            }
+
+            return table.str();
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace GL
+{
+    // Expands #include "file" directives in shader sources. Paths are
+    // relative to the including file and each file is included once per
+    // program, so headers need no guards. Included text is wrapped in
+    // #line directives, the root file is source string 0 and every include
+    // gets a stable number listed by SourceTable.
+    namespace Preprocessor
+    {
+        // Safe to call from worker threads
+        std::string Expand(
+            const std::string& file_path);
+
+        // True when file_path included dependency_path when last expanded
+        bool DependsOn(
+            const std::string& file_path,
+            const std::string& dependency_path);
+
+        // Everything file_path included when last expanded
+        std::vector<std::string> Dependencies(
+            const std::string& file_path);
+
+        std::string SourceTable();
+    }
+}
@@ -0,0 +1,280 @@
+#include "ProgramCache.hpp"
+
+#include "../File.hpp"
+#include "../Hash.hpp"
+#include "../Snapshot.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <optional>
+#include <filesystem>
+
+namespace GL
+{
+    namespace ProgramCache
+    {
+        constexpr uint32_t cache_magic = 0x42504C47; // "GLPB"
+        const std::string cache_directory = "cache/programs/";
+        const std::string snapshot_kind = "program";
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t format;
+            uint32_t length;
+        };
+
+        static Report report;
+        static std::optional<bool> enabled;
+        static uint64_t driver_hash = 0;
+
+        std::string DriverString(
+            const GLenum name)
+        {
+            const GLubyte* value = glGetString(name);
+
+            if (value == nullptr)
+            {
+                return "";
+            }
+
+            return reinterpret_cast<const char*>(value);
+        }
+
+        std::string EntryPath(
+            const uint64_t key)
+        {
+            std::stringstream path;
+            path << cache_directory;
+            path << std::hex << std::setw(16) << std::setfill('0') << key;
+            path << ".bin";
+            return path.str();
+        }
+
+        bool Enabled()
+        {
+            if (enabled.has_value())
+            {
+                return enabled.value();
+            }
+
+#if defined(EMSCRIPTEN)
+            enabled = false;
+#else
+            GLint num_formats = 0;
+            glGetIntegerv(
+                GL_NUM_PROGRAM_BINARY_FORMATS,
+                &num_formats);
+
+            std::error_code error;
+            std::filesystem::create_directories(
+                cache_directory,
+                error);
+
+            enabled = num_formats > 0 && !error;
+
+            driver_hash = hash_fnv1a(DriverString(GL_VENDOR));
+            driver_hash = hash_fnv1a(DriverString(GL_RENDERER), driver_hash);
+            driver_hash = hash_fnv1a(DriverString(GL_VERSION), driver_hash);
+#endif
+
+            return enabled.value();
+        }
+
+        uint64_t Key(
+            const std::string& vertex_shader_string,
+            const std::string& fragment_shader_string)
+        {
+            Enabled();
+
+            uint64_t key = hash_fnv1a(
+                vertex_shader_string,
+                driver_hash);
+
+            // Separator so moving text between stages changes the key
+            key = hash_fnv1a(std::string_view("\0", 1), key);
+
+            return hash_fnv1a(
+                fragment_shader_string,
+                key);
+        }
+
+        GLuint Load(
+            const uint64_t key)
+        {
+            if (!Enabled())
+            {
+                return 0;
+            }
+
+            const std::string path = EntryPath(key);
+
+            // Warm starts find every entry in the snapshot, without an
+            // open per program
+            std::optional<std::string_view> entry = Snapshot::Find(
+                snapshot_kind,
+                key);
+
+            std::optional<MappedFile> file;
+
+            if (!entry.has_value())
+            {
+                if (!std::filesystem::exists(path))
+                {
+                    report.misses++;
+                    return 0;
+                }
+
+                // The driver reads the binary straight out of the mapping
+                file.emplace(path);
+                entry = file->View();
+            }
+
+            Header header = {};
+
+            if (entry->size() >= sizeof(Header))
+            {
+                std::memcpy(
+                    &header,
+                    entry->data(),
+                    sizeof(Header));
+            }
+
+            const bool valid =
+                entry->size() >= sizeof(Header) &&
+                header.magic == cache_magic &&
+                header.length > 0 &&
+                header.length == entry->size() - sizeof(Header);
+
+            GLuint program_object = 0;
+            GLint linked = GL_FALSE;
+
+            if (valid)
+            {
+                program_object = glCreateProgram();
+
+                glProgramBinary(
+                    program_object,
+                    header.format,
+                    entry->data() + sizeof(Header),
+                    static_cast<GLsizei>(header.length));
+
+                glGetProgramiv(
+                    program_object,
+                    GL_LINK_STATUS,
+                    &linked);
+            }
+
+            if (!linked)
+            {
+                // Drivers reject binaries after updates or for any reason
+                // they choose, the caller falls back to a source compile.
+                if (program_object != 0)
+                {
+                    glDeleteProgram(
+                        program_object);
+                }
+
+                std::error_code error;
+                std::filesystem::remove(path, error);
+
+                Snapshot::Erase(
+                    snapshot_kind,
+                    key);
+
+                report.rejected++;
+                report.misses++;
+                return 0;
+            }
+
+            if (file.has_value())
+            {
+                Snapshot::Store(
+                    snapshot_kind,
+                    key,
+                    std::string(*entry));
+            }
+
+            report.hits++;
+            return program_object;
+        }
+
+        void Store(
+            const uint64_t key,
+            const GLuint program)
+        {
+            if (!Enabled())
+            {
+                return;
+            }
+
+            GLint length = 0;
+            glGetProgramiv(
+                program,
+                GL_PROGRAM_BINARY_LENGTH,
+                &length);
+
+            if (length <= 0)
+            {
+                return;
+            }
+
+            std::vector<uint8_t> binary(length);
+            Header header = {
+                cache_magic,
+                0,
+                0
+            };
+
+            GLsizei written = 0;
+            glGetProgramBinary(
+                program,
+                length,
+                &written,
+                &header.format,
+                binary.data());
+
+            if (written <= 0)
+            {
+                return;
+            }
+
+            header.length = static_cast<uint32_t>(written);
+
+            std::string entry(
+                reinterpret_cast<const char*>(&header),
+                sizeof(Header));
+
+            entry.append(
+                reinterpret_cast<const char*>(binary.data()),
+                header.length);
+
+            try
+            {
+                File file(EntryPath(key), "wb");
+                file.Write(entry.data(), 1, entry.size());
+            }
+            catch (const std::runtime_error&)
+            {
+                // Cache is best effort, a read-only install still runs
+            }
+
+            Snapshot::Store(
+                snapshot_kind,
+                key,
+                std::move(entry));
+        }
+
+        void AddLinkTime(
+            const float milliseconds)
+        {
+            report.link_ms += milliseconds;
+        }
+
+        const Report& Stats()
+        {
+            return report;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "OpenGL.hpp"
+
+namespace GL
+{
+    // On-disk cache of linked program binaries. Entries are keyed by the
+    // full stage sources (which include the defines) and the driver
+    // identification strings, so a driver update invalidates everything.
+    namespace ProgramCache
+    {
+        struct Report
+        {
+            uint32_t hits = 0;
+            uint32_t misses = 0;
+            uint32_t rejected = 0;
+            float link_ms = 0;
+        };
+
+        bool Enabled();
+
+        uint64_t Key(
+            const std::string& vertex_shader_string,
+            const std::string& fragment_shader_string);
+
+        // Returns a linked program, or 0 when there is no usable entry.
+        GLuint Load(
+            const uint64_t key);
+
+        void Store(
+            const uint64_t key,
+            const GLuint program);
+
+        void AddLinkTime(
+            const float milliseconds);
+
+        const Report& Stats();
+    }
+}
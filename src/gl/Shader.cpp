@@ -1,8 +1,18 @@
 #include "Shader.hpp"
 
+#include "State.hpp"
 #include "Parser.hpp"
 #include "Texture2D.hpp"
+#include "Preprocessor.hpp"
+#include "EmbeddedShaders.hpp"
 #include "../File.hpp"
+#include "../Hash.hpp"
+#include "../Async.hpp"
+#include "../Snapshot.hpp"
+
+#include <sstream>
+#include <algorithm>
+#include <iostream>
 
 const std::map<std::string, uint16_t> attribute_size_map =
 {
@@ -13,6 +23,44 @@ const std::map<std::string, uint16_t> attribute_size_map =
 
 constexpr GLuint gl_not_found = std::numeric_limits<GLuint>::max();
 
+const std::string reflection_snapshot_kind = "reflection";
+
+uint64_t reflection_snapshot_key(
+    const std::string& program)
+{
+    const uint32_t version = Parser::serialization_version;
+
+    return hash_fnv1a(
+        program,
+        hash_fnv1a(&version, sizeof(version)));
+}
+
+#if !defined(EMSCRIPTEN)
+const std::map<Access, GLenum> image_access_map =
+{
+    std::make_pair(Access::READ_ONLY, GL_READ_ONLY),
+    std::make_pair(Access::WRITE_ONLY, GL_WRITE_ONLY),
+    std::make_pair(Access::READ_WRITE, GL_READ_WRITE),
+};
+#endif
+
+const std::map<std::string, GLenum> image_format_map =
+{
+    std::make_pair("rgba32f", GL_RGBA32F),
+    std::make_pair("rgba16f", GL_RGBA16F),
+    std::make_pair("r32f", GL_R32F),
+    std::make_pair("rgba8", GL_RGBA8),
+    std::make_pair("rgba8_snorm", GL_RGBA8_SNORM),
+    std::make_pair("rgba32i", GL_RGBA32I),
+    std::make_pair("rgba16i", GL_RGBA16I),
+    std::make_pair("rgba8i", GL_RGBA8I),
+    std::make_pair("r32i", GL_R32I),
+    std::make_pair("rgba32ui", GL_RGBA32UI),
+    std::make_pair("rgba16ui", GL_RGBA16UI),
+    std::make_pair("rgba8ui", GL_RGBA8UI),
+    std::make_pair("r32ui", GL_R32UI),
+};
+
 namespace GL
 {
     Shader::~Shader()
@@ -23,106 +71,561 @@ namespace GL
         }
     }
 
+    std::future<std::string> ReadProgram(
+        AssetLoader* loader,
+        const std::string file_path,
+        const LoadPriority priority = LoadPriority::IMMEDIATE)
+    {
+        const auto read = [file_path]() {
+            return Preprocessor::Expand(
+                file_path);
+        };
+
+        if (loader != nullptr)
+        {
+            return loader->Async<std::string>(
+                read,
+                priority);
+        }
+
+        return run_async(
+            read);
+    }
+
+    std::future<Parser> ReflectProgram(
+        AssetLoader* loader,
+        const std::string program)
+    {
+        const auto reflect = [program]() {
+            return Parser(program);
+        };
+
+        if (loader != nullptr)
+        {
+            return loader->Async<Parser>(
+                reflect);
+        }
+
+        return run_async(
+            reflect);
+    }
+
     void Shader::Load(
-        const std::string file_path)
+        const std::string file_path_,
+        AssetLoader* loader_,
+        const LoadPriority priority)
+    {
+        file_path = file_path_;
+        loader = loader_;
+
+        embedded = EmbeddedShaders::Find(
+            file_path);
+
+        if (embedded != nullptr)
+        {
+            return;
+        }
+
+        pending_program = ReadProgram(
+            loader,
+            file_path,
+            priority);
+    }
+
+    void Shader::LoadCompute(
+        const std::string file_path_,
+        AssetLoader* loader_,
+        const LoadPriority priority)
     {
-        File file(file_path, "r");
+        compute = true;
 
-        program = file.ReadString();
+        Load(
+            file_path_,
+            loader_,
+            priority);
     }
 
     void Shader::Link(
         const std::string additional_defines)
     {
+        if (embedded != nullptr)
+        {
+            program = std::string(embedded->source);
+        }
+        else if (pending_program.valid())
+        {
+            program = pending_program.get();
+        }
+
         initialized = true;
+        defines = additional_defines;
 
-        gl_shader_handle = LinkShaderFile(
-            program,
-            additional_defines);
+        variants.clear();
+        option_variants.clear();
+
+        ShaderVariant& base = variants[base_variant];
+        base.defines = defines;
+
+        Submit(
+            base);
+
+        // Reflection of the exact source from a previous run
+        std::optional<Parser> snapshot_reflection;
+
+        if (embedded == nullptr)
+        {
+            const auto snapshot = Snapshot::Find(
+                reflection_snapshot_kind,
+                reflection_snapshot_key(program));
+
+            if (snapshot.has_value())
+            {
+                snapshot_reflection = Parser::Deserialize(
+                    snapshot.value());
+            }
+        }
+
+        if (embedded != nullptr)
+        {
+            reflection = embedded->reflection();
+            reflected = true;
+        }
+        else if (snapshot_reflection.has_value())
+        {
+            reflection = std::move(snapshot_reflection.value());
+            reflected = true;
+        }
+        else
+        {
+            // Reflection is CPU only, overlap it with the driver compile
+            reflected = false;
+            pending_reflection = ReflectProgram(
+                loader,
+                program);
+        }
+
+        descriptors.clear();
+        descriptors[0] = Descriptor();
+    }
+
+    void Shader::Options(
+        const std::vector<std::string> option_defines)
+    {
+        options = option_defines;
+        option_variants.clear();
+    }
+
+    uint64_t Shader::Variant(
+        const uint32_t option_mask)
+    {
+        if (option_mask == 0)
+        {
+            return base_variant;
+        }
+
+        const auto it = option_variants.find(option_mask);
+
+        if (it != option_variants.end())
+        {
+            return it->second;
+        }
+
+        const uint64_t variant = Variant(
+            OptionDefines(option_mask));
+
+        option_variants[option_mask] = variant;
+
+        return variant;
+    }
+
+    std::string Shader::OptionDefines(
+        const uint32_t option_mask) const
+    {
+        std::stringstream option_defines;
+
+        for (size_t i = 0; i < options.size(); i++)
+        {
+            if (option_mask & (1u << i))
+            {
+                option_defines << "#define " << options[i] << std::endl;
+            }
+        }
+
+        return option_defines.str();
+    }
+
+    uint64_t Shader::Variant(
+        const std::string& variant_defines,
+        const bool cacheable)
+    {
+        if (variant_defines.empty())
+        {
+            return base_variant;
+        }
+
+        const std::string full_defines =
+            defines + "\n" + variant_defines;
+
+        const uint64_t variant = hash_fnv1a(
+            full_defines);
+
+        ShaderVariant& entry = variants[variant];
+
+        if (entry.defines.empty())
+        {
+            entry.defines = full_defines;
+        }
+
+        if (!cacheable)
+        {
+            entry.cacheable = false;
+        }
+
+        return variant;
+    }
+
+    void Shader::Prewarm(
+        const uint64_t variant)
+    {
+        ShaderVariant& entry = variants.at(variant);
+
+        if (!entry.submitted)
+        {
+            Submit(
+                entry);
+        }
+    }
+
+    bool Shader::Ready(
+        const uint64_t variant) const
+    {
+        const auto it = variants.find(variant);
+
+        if (it == variants.end())
+        {
+            return false;
+        }
+
+        const ShaderVariant& entry = it->second;
+
+        if (entry.linked)
+        {
+            return true;
+        }
+
+        const bool reflection_ready = reflected ||
+            pending_reflection.wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready;
+
+        return
+            entry.submitted &&
+            reflection_ready &&
+            ProgramBuildComplete(entry.build);
+    }
+
+    void Shader::Evict(
+        const uint64_t variant)
+    {
+        if (variant == base_variant)
+        {
+            return;
+        }
+
+        const auto it = variants.find(variant);
+
+        if (it == variants.end())
+        {
+            return;
+        }
+
+        DeleteProgramBuild(
+            it->second.build);
+
+        DeleteProgramBuild(
+            it->second.reload_build);
+
+        variants.erase(it);
+
+        for (auto option = option_variants.begin();
+            option != option_variants.end();)
+        {
+            option = option->second == variant ?
+                option_variants.erase(option) :
+                std::next(option);
+        }
+    }
+
+    void Shader::Finish(
+        const uint64_t variant)
+    {
+        ShaderVariant& entry = variants.at(variant);
+
+        if (!entry.linked)
+        {
+            Resolve(
+                entry);
+        }
+    }
+
+    const Parser& Shader::Reflection()
+    {
+        if (!reflected)
+        {
+            reflection = pending_reflection.get();
+            reflected = true;
+
+            Snapshot::Store(
+                reflection_snapshot_kind,
+                reflection_snapshot_key(program),
+                reflection.Serialize());
+        }
+
+        return reflection;
+    }
+
+    void Shader::Submit(
+        ShaderVariant& variant)
+    {
+        variant.build = compute ?
+            SubmitComputeShaderFile(
+                program,
+                variant.defines) :
+            SubmitShaderFile(
+                program,
+                variant.defines);
+
+        variant.build.cacheable = variant.cacheable;
+        variant.submitted = true;
+    }
+
+    void Shader::Resolve(
+        ShaderVariant& variant)
+    {
+        if (!variant.submitted)
+        {
+            Submit(
+                variant);
+        }
+
+        ShaderProgram resolved;
+
+        resolved.gl_shader_handle = FinishProgram(
+            variant.build);
 
         GL::CheckError();
 
-        const Parser vertex_info = Parser(
-            ShaderParseType::VERTEX,
-            program);
+        Reflect(
+            resolved,
+            Reflection());
 
-        const Parser fragment_info = Parser(
-            ShaderParseType::FRAGMENT,
-            program);
+        for (const auto& descriptor : descriptors)
+        {
+            ResolveSet(
+                resolved,
+                descriptor.second,
+                descriptor.first);
+        }
 
-        attributes_total_size = 0;
-        attribute_locations.clear();
-        sampler2D_locations.clear();
-        sampler2D_array_locations.clear();
-        uniform_block_locations.clear();
-        uniform_mat4_locations.clear();
-        uniform_float_locations.clear();
+        variant.program = std::move(resolved);
+        variant.linked = true;
+    }
 
-        descriptor_sets.clear();
+    // Offsets the driver assigned to the members of a linked block
+    UniformLayout BlockLayout(
+        const GLuint program,
+        const GLuint block_index,
+        const UniformBlock& block)
+    {
+        GLint data_size = 0;
+        glGetActiveUniformBlockiv(
+            program,
+            block_index,
+            GL_UNIFORM_BLOCK_DATA_SIZE,
+            &data_size);
 
-        Descriptor empty_set;
-        Set(empty_set, 0);
+        std::vector<std::string> names;
 
-        for (const auto& attribute : vertex_info.attributes)
+        for (const auto& member : block.members)
         {
-            const std::string type = std::get<0>(attribute);
-            const std::string name = std::get<1>(attribute);
+            const std::string& type = std::get<0>(member);
+            const std::string& name = std::get<1>(member);
 
-            const uint16_t size = attribute_size_map.at(type);
-            attributes_total_size += size;
+            const bool array =
+                type.size() > 2 &&
+                type.compare(type.size() - 2, 2, "[]") == 0;
 
-            const GLuint location = glGetAttribLocation(
-                gl_shader_handle,
-                name.c_str());
+            names.push_back(array ? name + "[0]" : name);
+        }
 
-            if (location == gl_not_found)
+        std::vector<const GLchar*> name_pointers;
+
+        for (const auto& name : names)
+        {
+            name_pointers.push_back(name.c_str());
+        }
+
+        const GLsizei count = static_cast<GLsizei>(names.size());
+
+        std::vector<GLuint> indices(names.size(), GL_INVALID_INDEX);
+        std::vector<GLint> offsets(names.size(), -1);
+
+        if (count > 0)
+        {
+            glGetUniformIndices(
+                program,
+                count,
+                name_pointers.data(),
+                indices.data());
+        }
+
+        UniformLayout layout = {
+            static_cast<size_t>(data_size),
+            {}
+        };
+
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            if (indices[i] == GL_INVALID_INDEX)
             {
-                // TODO print warning
                 continue;
             }
 
-            attribute_locations[location] = size;
+            glGetActiveUniformsiv(
+                program,
+                1,
+                &indices[i],
+                GL_UNIFORM_OFFSET,
+                &offsets[i]);
+
+            layout.members.push_back({
+                std::get<1>(block.members[i]),
+                static_cast<size_t>(offsets[i])
+            });
         }
 
-        auto uniform_sampler2Ds =
-            vertex_info.uniform_sampler2Ds;
+        return layout;
+    }
 
-        auto uniform_sampler2D_arrays =
-            vertex_info.uniform_sampler2D_arrays;
+    // Throws when the buffer bound to a block doesn't match what the
+    // driver laid out, so drift fails the link instead of reading garbage
+    void ValidateBlockLayout(
+        const std::string& block_name,
+        const UniformLayout& program_layout,
+        const UniformLayout& buffer_layout)
+    {
+        std::stringstream error;
 
-        auto uniform_blocks =
-            vertex_info.uniform_blocks;
+        if (buffer_layout.size < program_layout.size)
+        {
+            error << "  block is " << program_layout.size <<
+                " bytes, buffer is " << buffer_layout.size << std::endl;
+        }
 
-        auto uniform_mat4s =
-            vertex_info.uniform_mat4s;
+        for (const auto& member : program_layout.members)
+        {
+            const auto it = std::find_if(
+                buffer_layout.members.begin(),
+                buffer_layout.members.end(),
+                [&](const UniformMember& buffer_member) {
+                    return buffer_member.name == member.name;
+                });
+
+            if (it == buffer_layout.members.end())
+            {
+                error << "  " << member.name << " is missing from the buffer type" << std::endl;
+            }
+            else if (it->offset != member.offset)
+            {
+                error << "  " << member.name << " is at " << member.offset <<
+                    ", buffer type has it at " << it->offset << std::endl;
+            }
+        }
+
+        if (error.tellp() > 0)
+        {
+            throw std::runtime_error(
+                "Uniform block " + block_name + " layout mismatch:\n" + error.str());
+        }
+    }
+
+    void Shader::Reflect(
+        ShaderProgram& target,
+        const Parser& reflection) const
+    {
+        const StageReflection& vertex_info = reflection.Stage(
+            ShaderParseType::VERTEX);
+
+        const StageReflection& fragment_info = reflection.Stage(
+            ShaderParseType::FRAGMENT);
+
+        target.attributes_total_size = 0;
+        target.attribute_locations.clear();
+        target.sampler2D_locations.Clear();
+        target.sampler2D_array_locations.Clear();
+        target.image2D_units.Clear();
+        target.uniform_block_locations.Clear();
+        target.uniform_block_layouts.Clear();
+        target.storage_block_bindings.Clear();
+        target.uniform_mat4_locations.Clear();
+        target.uniform_float_locations.Clear();
 
-        auto uniform_floats =
-            vertex_info.uniform_floats;
+        for (const auto& attribute : vertex_info.attributes)
+        {
+            const std::string type = std::get<0>(attribute);
+            const std::string name = std::get<1>(attribute);
 
-        uniform_sampler2Ds.insert(
-            std::end(uniform_sampler2Ds),
-            std::begin(fragment_info.uniform_sampler2Ds),
-            std::end(fragment_info.uniform_sampler2Ds));
+            const uint16_t size = attribute_size_map.at(type);
+            target.attributes_total_size += size;
 
-        uniform_sampler2D_arrays.insert(
-            std::end(uniform_sampler2D_arrays),
-            std::begin(fragment_info.uniform_sampler2D_arrays),
-            std::end(fragment_info.uniform_sampler2D_arrays));
+            const GLuint location = glGetAttribLocation(
+                target.gl_shader_handle,
+                name.c_str());
 
-        uniform_blocks.insert(
-            std::end(uniform_blocks),
-            std::begin(fragment_info.uniform_blocks),
-            std::end(fragment_info.uniform_blocks));
+            if (location == gl_not_found)
+            {
+                // TODO print warning
+                continue;
+            }
 
-        uniform_mat4s.insert(
-            std::end(uniform_mat4s),
-            std::begin(fragment_info.uniform_mat4s),
-            std::end(fragment_info.uniform_mat4s));
+            target.attribute_locations[location] = size;
+        }
 
-        uniform_floats.insert(
-            std::end(uniform_floats),
-            std::begin(fragment_info.uniform_floats),
-            std::end(fragment_info.uniform_floats));
+        // A program is either the vertex and fragment stages or a compute
+        // stage alone, uniforms of the stages it contains are merged
+        const std::vector<const StageReflection*> stages = compute ?
+            std::vector<const StageReflection*> {
+                &reflection.Stage(ShaderParseType::COMPUTE)
+            } :
+            std::vector<const StageReflection*> {
+                &vertex_info,
+                &fragment_info
+            };
+
+        std::vector<TypePair> uniform_sampler2Ds;
+        std::vector<TypePair> uniform_sampler2D_arrays;
+        std::vector<TypePair> uniform_image2Ds;
+        std::vector<UniformBlock> uniform_blocks;
+        std::vector<UniformBlock> storage_blocks;
+        std::vector<TypePair> uniform_mat4s;
+        std::vector<TypePair> uniform_floats;
+
+        const auto Append = [](auto& merged, const auto& stage_list) {
+            merged.insert(
+                std::end(merged),
+                std::begin(stage_list),
+                std::end(stage_list));
+        };
+
+        for (const StageReflection* stage : stages)
+        {
+            Append(uniform_sampler2Ds, stage->uniform_sampler2Ds);
+            Append(uniform_sampler2D_arrays, stage->uniform_sampler2D_arrays);
+            Append(uniform_image2Ds, stage->uniform_image2Ds);
+            Append(uniform_blocks, stage->uniform_blocks);
+            Append(storage_blocks, stage->storage_blocks);
+            Append(uniform_mat4s, stage->uniform_mat4s);
+            Append(uniform_floats, stage->uniform_floats);
+        }
 
         for (const auto& sampler : uniform_sampler2Ds)
         {
@@ -130,10 +633,12 @@ namespace GL
             const std::string name = std::get<1>(sampler);
 
             const GLuint location = glGetUniformLocation(
-                gl_shader_handle,
+                target.gl_shader_handle,
                 name.c_str());
 
-            sampler2D_locations[name] = location;
+            target.sampler2D_locations.Set(
+                UniformId::Intern(name),
+                location);
         }
 
         for (const auto& sampler : uniform_sampler2D_arrays)
@@ -142,10 +647,47 @@ namespace GL
             const std::string name = std::get<1>(sampler);
 
             const GLuint location = glGetUniformLocation(
-                gl_shader_handle,
+                target.gl_shader_handle,
                 name.c_str());
 
-            sampler2D_array_locations[name] = location;
+            target.sampler2D_array_locations.Set(
+                UniformId::Intern(name),
+                location);
+        }
+
+        for (const auto& image : uniform_image2Ds)
+        {
+            const std::string format = std::get<0>(image);
+            const std::string name = std::get<1>(image);
+
+            const GLint location = glGetUniformLocation(
+                target.gl_shader_handle,
+                name.c_str());
+
+            if (location < 0)
+            {
+                target.image2D_units.Set(
+                    UniformId::Intern(name),
+                    {
+                        gl_not_found,
+                        GL_NONE
+                    });
+                continue;
+            }
+
+            // GLES only sets image units through layout(binding)
+            GLint unit = 0;
+            glGetUniformiv(
+                target.gl_shader_handle,
+                location,
+                &unit);
+
+            target.image2D_units.Set(
+                UniformId::Intern(name),
+                {
+                    static_cast<GLuint>(unit),
+                    image_format_map.at(format)
+                });
         }
 
         for (const auto& uniform_block : uniform_blocks)
@@ -153,10 +695,62 @@ namespace GL
             const std::string name = uniform_block.name;
 
             const GLuint location = glGetUniformBlockIndex(
-                gl_shader_handle,
+                target.gl_shader_handle,
                 name.c_str());
 
-            uniform_block_locations[name] = location;
+            target.uniform_block_locations.Set(
+                UniformId::Intern(name),
+                location);
+
+            if (location == GL_INVALID_INDEX)
+            {
+                continue;
+            }
+
+            target.uniform_block_layouts.Set(
+                UniformId::Intern(name),
+                BlockLayout(
+                    target.gl_shader_handle,
+                    location,
+                    uniform_block));
+        }
+
+        for (const auto& storage_block : storage_blocks)
+        {
+            const std::string name = storage_block.name;
+
+            target.storage_block_bindings.Set(
+                UniformId::Intern(name),
+                gl_not_found);
+
+#if !defined(EMSCRIPTEN)
+            const GLuint index = glGetProgramResourceIndex(
+                target.gl_shader_handle,
+                GL_SHADER_STORAGE_BLOCK,
+                name.c_str());
+
+            if (index == GL_INVALID_INDEX)
+            {
+                continue;
+            }
+
+            const GLenum property = GL_BUFFER_BINDING;
+            GLint binding = 0;
+
+            glGetProgramResourceiv(
+                target.gl_shader_handle,
+                GL_SHADER_STORAGE_BLOCK,
+                index,
+                1,
+                &property,
+                1,
+                nullptr,
+                &binding);
+
+            target.storage_block_bindings.Set(
+                UniformId::Intern(name),
+                binding);
+#endif
         }
 
         for (const auto& uniform : uniform_mat4s)
@@ -165,10 +759,12 @@ namespace GL
             const std::string name = std::get<1>(uniform);
 
             const GLuint location = glGetUniformLocation(
-                gl_shader_handle,
+                target.gl_shader_handle,
                 name.c_str());
 
-            uniform_mat4_locations[name] = location;
+            target.uniform_mat4_locations.Set(
+                UniformId::Intern(name),
+                location);
         }
 
         for (const auto& uniform : uniform_floats)
@@ -177,186 +773,479 @@ namespace GL
             const std::string name = std::get<1>(uniform);
 
             const GLuint location = glGetUniformLocation(
-                gl_shader_handle,
+                target.gl_shader_handle,
                 name.c_str());
 
-            uniform_float_locations[name] = location;
+            target.uniform_float_locations.Set(
+                UniformId::Intern(name),
+                location);
         }
     }
 
-    void Shader::Delete()
+    bool Shader::DependsOn(
+        const std::string& changed_path) const
     {
-        if (initialized)
+        if (embedded != nullptr)
         {
-            glDeleteProgram(
-                gl_shader_handle);
+            for (size_t i = 0; i < embedded->dependency_count; i++)
+            {
+                if (embedded->dependencies[i] == changed_path)
+                {
+                    return true;
+                }
+            }
         }
 
-        initialized = false;
+        return
+            changed_path == file_path ||
+            Preprocessor::DependsOn(file_path, changed_path);
     }
 
-    void Shader::Set(
-        const Descriptor& descriptor,
-        const uint32_t index)
+    void Shader::Reload()
     {
-        DescriptorSet set;
+        if (!initialized || file_path.empty() || reloading)
+        {
+            return;
+        }
 
-        for (const auto& sampler : descriptor.sampler2Ds)
+        reloading = true;
+        reload_submitted = false;
+
+        reload_program = ReadProgram(
+            loader,
+            file_path);
+    }
+
+    void Shader::CancelReload()
+    {
+        for (auto& variant : variants)
         {
-            const std::string name = sampler.first;
-            const SamplerDescriptor& desc = sampler.second;
+            DeleteProgramBuild(
+                variant.second.reload_build);
+        }
+
+        reloading = false;
+    }
 
-            if (sampler2D_locations.find(name) ==
-                sampler2D_locations.end())
+    void Shader::UpdateReload()
+    {
+        const auto IsReady = [](const auto& future) {
+            return future.wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready;
+        };
+
+        // Variants submitted after the reload started, e.g. a prewarmed
+        // specialisation, get their build of the new source on a later call
+        const auto SubmitReloadBuilds = [this]() {
+            for (auto& variant : variants)
             {
-                throw new std::runtime_error(
-                    "No matching uniform found");
+                if (!variant.second.submitted ||
+                    variant.second.reload_build.program != 0)
+                {
+                    continue;
+                }
+
+                variant.second.reload_build = compute ?
+                    SubmitComputeShaderFile(
+                        reload_source,
+                        variant.second.defines) :
+                    SubmitShaderFile(
+                        reload_source,
+                        variant.second.defines);
+
+                variant.second.reload_build.cacheable =
+                    variant.second.cacheable;
             }
+        };
 
-            const GLuint location = sampler2D_locations.at(
-                name);
+        if (!reload_submitted)
+        {
+            if (!IsReady(reload_program))
+            {
+                return;
+            }
 
-            if (location == gl_not_found)
+            try
             {
-                // TODO print warning
-                continue;
+                reload_source = reload_program.get();
+
+                SubmitReloadBuilds();
+            }
+            catch (const std::exception& e)
+            {
+                std::cout << "Reload of " << file_path <<
+                    " failed: " << e.what() << std::endl;
+                CancelReload();
+                return;
             }
 
-            set.sampler2Ds.push_back({
-                location,
-                desc
-            });
+            reload_reflection = ReflectProgram(
+                loader,
+                reload_source);
+
+            reload_submitted = true;
+            return;
         }
 
-        for (const auto& sampler : descriptor.sampler2D_arrays)
+        try
         {
-            const std::string name = sampler.first;
-            const SamplerDescriptor& desc = sampler.second;
-
-            if (sampler2D_array_locations.find(name) ==
-                sampler2D_array_locations.end())
-            {
-                throw new std::runtime_error(
-                    "No matching uniform found");
-            }
+            SubmitReloadBuilds();
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << "Reload of " << file_path <<
+                " failed: " << e.what() << std::endl;
+            CancelReload();
+            return;
+        }
 
-            const GLuint location = sampler2D_array_locations.at(
-                name);
+        if (!IsReady(reload_reflection))
+        {
+            return;
+        }
 
-            if (location == gl_not_found)
+        for (const auto& variant : variants)
+        {
+            if (variant.second.submitted &&
+                !ProgramBuildComplete(variant.second.reload_build))
             {
-                // TODO print warning
-                continue;
+                return;
             }
-
-            set.sampler2D_arrays.push_back({
-                location,
-                desc
-            });
         }
 
-        for (const auto& ubo : descriptor.uniform_blocks)
+        Parser reloaded_reflection;
+        std::unordered_map<uint64_t, ShaderProgram> reloaded;
+
+        try
         {
-            const std::string name = ubo.first;
-            const GLuint handle = ubo.second;
+            reloaded_reflection = reload_reflection.get();
 
-            if (uniform_block_locations.find(name) ==
-                uniform_block_locations.end())
+            for (auto& variant : variants)
             {
-                throw new std::runtime_error(
-                    "No matching uniform block found");
+                if (!variant.second.submitted)
+                {
+                    continue;
+                }
+
+                ShaderProgram& target = reloaded[variant.first];
+
+                target.gl_shader_handle = FinishProgram(
+                    variant.second.reload_build);
+
+                Reflect(
+                    target,
+                    reloaded_reflection);
+
+                for (const auto& descriptor : descriptors)
+                {
+                    ResolveSet(
+                        target,
+                        descriptor.second,
+                        descriptor.first);
+                }
             }
+        }
+        catch (...)
+        {
+            std::cout << "Reload of " << file_path <<
+                " failed, keeping previous program" << std::endl;
+            CancelReload();
+            return;
+        }
 
-            const GLuint location = uniform_block_locations.at(
-                name);
-
-            if (location == gl_not_found)
+        for (auto& variant : variants)
+        {
+            if (!variant.second.submitted)
             {
-                // TODO print warning
                 continue;
             }
 
-            set.uniform_blocks.push_back({
-                location,
-                handle
-            });
+            DeleteProgramBuild(
+                variant.second.build);
+
+            variant.second.build = variant.second.reload_build;
+            variant.second.reload_build = ProgramBuild();
+            variant.second.program = std::move(reloaded[variant.first]);
+            variant.second.linked = true;
         }
 
-        for (const auto& uniform : descriptor.uniform_mat4s)
+        // From here on the disk copy is authoritative
+        embedded = nullptr;
+
+        program = reload_source;
+        reflection = std::move(reloaded_reflection);
+        reflected = true;
+        reloading = false;
+
+        std::cout << "Reloaded " << file_path << std::endl;
+    }
+
+    void Shader::Delete()
+    {
+        if (initialized)
         {
-            const std::string name = uniform.first;
-            glm::mat4* data = uniform.second;
+            if (pending_reflection.valid())
+            {
+                pending_reflection.wait();
+            }
 
-            if (uniform_mat4_locations.find(name) ==
-                uniform_mat4_locations.end())
+            for (auto& variant : variants)
             {
-                throw new std::runtime_error(
-                    "No matching uniform found");
+                DeleteProgramBuild(
+                    variant.second.build);
+
+                DeleteProgramBuild(
+                    variant.second.reload_build);
             }
+        }
 
-            const GLuint location = uniform_mat4_locations.at(
-                name);
+        variants.clear();
+        option_variants.clear();
 
-            if (location == gl_not_found)
+        initialized = false;
+        reloading = false;
+    }
+
+    void Shader::Set(
+        const Descriptor& descriptor,
+        const uint32_t index)
+    {
+        descriptors[index] = descriptor;
+
+        for (auto& variant : variants)
+        {
+            if (variant.second.linked)
             {
-                // TODO print warning
-                continue;
+                ResolveSet(
+                    variant.second.program,
+                    descriptor,
+                    index);
             }
-
-            set.uniform_mat4s.push_back({
-                location,
-                data
-            });
         }
+    }
 
-        for (const auto& uniform : descriptor.uniform_floats)
+    // Both tables are sorted by id, so matching every binding against the
+    // program is a single walk over the two
+    template <typename Binding, typename Location, typename Resolve>
+    void MatchBindings(
+        const UniformTable<Binding>& bindings,
+        const UniformTable<Location>& locations,
+        const char* kind,
+        Resolve resolve)
+    {
+        auto location = locations.begin();
+
+        for (const auto& binding : bindings)
         {
-            const std::string name = uniform.first;
-            float* data = uniform.second;
+            const UniformId id = std::get<0>(binding);
 
-            if (uniform_float_locations.find(name) ==
-                uniform_float_locations.end())
+            while (location != locations.end() && std::get<0>(*location) < id)
             {
-                throw new std::runtime_error(
-                    "No matching uniform found");
+                location++;
             }
 
-            const GLuint location = uniform_float_locations.at(
-                name);
-
-            if (location == gl_not_found)
+            if (location == locations.end() ||
+                !(std::get<0>(*location) == id) ||
+                std::get<0>(*location).Name() != id.Name())
             {
-                // TODO print warning
-                continue;
+                throw std::runtime_error(
+                    std::string("No matching ") + kind + " found: " +
+                    std::string(id.Name()));
             }
 
-            set.uniform_floats.push_back({
-                location,
-                data
-            });
+            resolve(
+                id,
+                std::get<1>(binding),
+                std::get<1>(*location));
         }
+    }
+
+    void Shader::ResolveSet(
+        ShaderProgram& target,
+        const Descriptor& descriptor,
+        const uint32_t index) const
+    {
+        // Refilled in place, rebuilding a set with the same bindings
+        // reuses the previous storage
+        DescriptorSet& set = target.descriptor_sets[index];
+        set.Clear();
+
+        MatchBindings(
+            descriptor.sampler2Ds,
+            target.sampler2D_locations,
+            "uniform",
+            [&](const UniformId, const SamplerDescriptor& desc, const GLuint location) {
+                if (location == gl_not_found)
+                {
+                    // TODO print warning
+                    return;
+                }
+
+                set.sampler2Ds.push_back({
+                    location,
+                    desc
+                });
+            });
+
+        MatchBindings(
+            descriptor.sampler2D_arrays,
+            target.sampler2D_array_locations,
+            "uniform",
+            [&](const UniformId, const SamplerDescriptor& desc, const GLuint location) {
+                if (location == gl_not_found)
+                {
+                    // TODO print warning
+                    return;
+                }
+
+                set.sampler2D_arrays.push_back({
+                    location,
+                    desc
+                });
+            });
+
+        MatchBindings(
+            descriptor.image2Ds,
+            target.image2D_units,
+            "image",
+            [&](const UniformId id, const ImageDescriptor& desc, const std::tuple<GLuint, GLenum>& image) {
+                const auto& [unit, format] = image;
+
+                // Nothing is written through an image left unbound
+                if (unit == gl_not_found)
+                {
+                    std::cout << "Shader " << file_path <<
+                        ": image " << id.Name() <<
+                        " is inactive, binding dropped" << std::endl;
+                    return;
+                }
+
+                set.image2Ds.push_back({
+                    unit,
+                    format,
+                    desc
+                });
+            });
+
+        MatchBindings(
+            descriptor.uniform_blocks,
+            target.uniform_block_locations,
+            "uniform block",
+            [&](const UniformId id, const UniformBlockDescriptor& desc, const GLuint location) {
+                if (location == gl_not_found)
+                {
+                    // TODO print warning
+                    return;
+                }
+
+                if (desc.layout != nullptr)
+                {
+                    ValidateBlockLayout(
+                        std::string(id.Name()),
+                        *target.uniform_block_layouts.Find(id),
+                        *desc.layout);
+                }
+
+                set.uniform_blocks.push_back({
+                    location,
+                    desc.handle
+                });
+            });
+
+        MatchBindings(
+            descriptor.storage_buffers,
+            target.storage_block_bindings,
+            "storage block",
+            [&](const UniformId id, const GLuint handle, const GLuint binding) {
+                if (binding == gl_not_found)
+                {
+                    std::cout << "Shader " << file_path <<
+                        ": storage block " << id.Name() <<
+                        " is inactive, binding dropped" << std::endl;
+                    return;
+                }
+
+                set.storage_buffers.push_back({
+                    binding,
+                    handle
+                });
+            });
+
+        MatchBindings(
+            descriptor.uniform_mat4s,
+            target.uniform_mat4_locations,
+            "uniform",
+            [&](const UniformId, glm::mat4* const data, const GLuint location) {
+                if (location == gl_not_found)
+                {
+                    // TODO print warning
+                    return;
+                }
+
+                set.uniform_mat4s.push_back({
+                    location,
+                    data
+                });
+            });
 
-        descriptor_sets[index] = set;
+        MatchBindings(
+            descriptor.uniform_floats,
+            target.uniform_float_locations,
+            "uniform",
+            [&](const UniformId, float* const data, const GLuint location) {
+                if (location == gl_not_found)
+                {
+                    // TODO print warning
+                    return;
+                }
+
+                set.uniform_floats.push_back({
+                    location,
+                    data
+                });
+            });
     }
 
     void Shader::Bind(
-        const uint32_t descriptor_set_index)
+        const uint32_t descriptor_set_index,
+        const uint64_t variant)
     {
+        if (reloading)
+        {
+            UpdateReload();
+        }
+
+        const auto it = variants.find(variant);
+
+        if (it == variants.end())
+        {
+            throw std::runtime_error(
+                "No matching shader variant found");
+        }
+
+        if (!it->second.linked)
+        {
+            Resolve(
+                it->second);
+        }
+
+        ShaderProgram& active = it->second.program;
+
         GL::CheckError();
 
-        glUseProgram(
-            gl_shader_handle);
+        State::UseProgram(
+            active.gl_shader_handle);
 
         GL::CheckError();
 
         GLuint accumulated_size = 0;
 
-        for (auto& attribute : attribute_locations)
+        for (auto& attribute : active.attribute_locations)
         {
             const GLuint location = attribute.first;
             const GLuint size = attribute.second;
 
-            glEnableVertexAttribArray(
+            State::EnableVertexAttribArray(
                 location);
 
             glVertexAttribPointer(
@@ -364,7 +1253,7 @@ namespace GL
                 size,
                 GL_FLOAT,
                 GL_FALSE,
-                attributes_total_size * sizeof(GLfloat),
+                active.attributes_total_size * sizeof(GLfloat),
                 (GLvoid*)(accumulated_size * sizeof(GLfloat)));
 
             accumulated_size += size;
@@ -372,25 +1261,25 @@ namespace GL
 
         GL::CheckError();
 
-        if (descriptor_sets.find(descriptor_set_index) ==
-            descriptor_sets.end())
+        if (active.descriptor_sets.find(descriptor_set_index) ==
+            active.descriptor_sets.end())
         {
-            throw new std::runtime_error(
+            throw std::runtime_error(
                 "No matching descriptor set found");
         }
 
         uint32_t sampler_count = 0;
-        DescriptorSet& set = descriptor_sets[descriptor_set_index];
+        DescriptorSet& set = active.descriptor_sets[descriptor_set_index];
 
         for (const auto& texture : set.sampler2Ds)
         {
             const GLuint location = std::get<0>(texture);
             const SamplerDescriptor& desc = std::get<1>(texture);
 
-            glActiveTexture(
+            State::ActiveTexture(
                 GL_TEXTURE0 + sampler_count);
 
-            glBindTexture(
+            State::BindTexture(
                 GL_TEXTURE_2D,
                 desc.handle);
 
@@ -433,10 +1322,10 @@ namespace GL
             const GLuint location = std::get<0>(texture);
             const SamplerDescriptor& desc = std::get<1>(texture);
 
-            glActiveTexture(
+            State::ActiveTexture(
                 GL_TEXTURE0 + sampler_count);
 
-            glBindTexture(
+            State::BindTexture(
                 GL_TEXTURE_2D_ARRAY,
                 desc.handle);
 
@@ -477,17 +1366,41 @@ namespace GL
             const GLuint location = std::get<0>(ubo);
             const GLuint handle = std::get<1>(ubo);
 
-            glBindBufferBase(
+            State::BindBufferBase(
                 GL_UNIFORM_BUFFER,
                 location,
                 handle);
 
             glUniformBlockBinding(
-                gl_shader_handle,
+                active.gl_shader_handle,
                 location,
                 location);
         }
 
+#if !defined(EMSCRIPTEN)
+        for (const auto& image : set.image2Ds)
+        {
+            const ImageDescriptor& desc = std::get<2>(image);
+
+            glBindImageTexture(
+                std::get<0>(image),
+                desc.handle,
+                desc.level,
+                GL_FALSE,
+                0,
+                image_access_map.at(desc.access),
+                std::get<1>(image));
+        }
+
+        for (const auto& ssbo : set.storage_buffers)
+        {
+            State::BindBufferBase(
+                GL_SHADER_STORAGE_BUFFER,
+                std::get<0>(ssbo),
+                std::get<1>(ssbo));
+        }
+#endif
+
         for (const auto& uniform : set.uniform_mat4s)
         {
             const GLuint location = std::get<0>(uniform);
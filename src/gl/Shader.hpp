@@ -1,10 +1,16 @@
 #pragma once
 
 #include "OpenGL.hpp"
+#include "Parser.hpp"
 #include "Descriptor.hpp"
+#include "UniformId.hpp"
+#include "EmbeddedShaders.hpp"
+
+#include "../AssetLoader.hpp"
 
 #include <map>
 #include <tuple>
+#include <future>
 #include <vector>
 #include <string>
 
@@ -15,43 +21,189 @@ namespace GL
     public:
         std::vector<std::tuple<GLuint, SamplerDescriptor>> sampler2Ds;
         std::vector<std::tuple<GLuint, SamplerDescriptor>> sampler2D_arrays;
+        std::vector<std::tuple<GLuint, GLenum, ImageDescriptor>> image2Ds;
         std::vector<std::tuple<GLuint, GLuint>> uniform_blocks;
+        std::vector<std::tuple<GLuint, GLuint>> storage_buffers;
         std::vector<std::tuple<GLuint, glm::mat4*>> uniform_mat4s;
         std::vector<std::tuple<GLuint, float*>> uniform_floats;
+
+        void Clear()
+        {
+            sampler2Ds.clear();
+            sampler2D_arrays.clear();
+            image2Ds.clear();
+            uniform_blocks.clear();
+            storage_buffers.clear();
+            uniform_mat4s.clear();
+            uniform_floats.clear();
+        }
     };
 
-    class Shader
+    // Locations and resolved descriptor sets of one linked program
+    class ShaderProgram
     {
-    private:
-        GLuint gl_shader_handle;
+    public:
+        GLuint gl_shader_handle = 0;
 
         std::unordered_map<uint32_t, DescriptorSet> descriptor_sets;
 
         uint16_t attributes_total_size = 0;
         std::map<GLuint, GLuint> attribute_locations;
 
-        std::map<std::string, GLuint> sampler2D_locations;
-        std::map<std::string, GLuint> sampler2D_array_locations;
-        std::map<std::string, GLuint> uniform_block_locations;
-        std::map<std::string, GLuint> uniform_mat4_locations;
-        std::map<std::string, GLuint> uniform_float_locations;
+        UniformTable<GLuint> sampler2D_locations;
+        UniformTable<GLuint> sampler2D_array_locations;
+        UniformTable<std::tuple<GLuint, GLenum>> image2D_units;
+        UniformTable<GLuint> uniform_block_locations;
+        UniformTable<UniformLayout> uniform_block_layouts;
+        UniformTable<GLuint> storage_block_bindings;
+        UniformTable<GLuint> uniform_mat4_locations;
+        UniformTable<GLuint> uniform_float_locations;
+    };
+
+    class ShaderVariant
+    {
+    public:
+        std::string defines;
+
+        ProgramBuild build;
+        ProgramBuild reload_build;
+        ShaderProgram program;
+
+        bool submitted = false;
+        bool linked = false;
+        bool cacheable = true;
+    };
 
+    class Shader
+    {
+    private:
         bool initialized = false;
+        bool compute = false;
 
+        std::string file_path;
         std::string program;
 
+        // Reads and reflection run on its workers when Load was given one
+        AssetLoader* loader = nullptr;
+
+        // Set when the build embedded this shader, Load skips file access
+        const EmbeddedShaders::Entry* embedded = nullptr;
+        std::string defines;
+
+        std::vector<std::string> options;
+        std::unordered_map<uint32_t, uint64_t> option_variants;
+        std::unordered_map<uint64_t, ShaderVariant> variants;
+
+        std::future<std::string> pending_program;
+        std::future<Parser> pending_reflection;
+
+        // Parser results depend only on the source, all variants share them
+        Parser reflection;
+        bool reflected = false;
+
+        bool reloading = false;
+        bool reload_submitted = false;
+        std::string reload_source;
+        std::future<std::string> reload_program;
+        std::future<Parser> reload_reflection;
+
+        std::map<uint32_t, Descriptor> descriptors;
+
+        const Parser& Reflection();
+
+        void Submit(
+            ShaderVariant& variant);
+
+        void Resolve(
+            ShaderVariant& variant);
+
+        void UpdateReload();
+
+        void CancelReload();
+
+        void Reflect(
+            ShaderProgram& target,
+            const Parser& reflection) const;
+
+        void ResolveSet(
+            ShaderProgram& target,
+            const Descriptor& descriptor,
+            const uint32_t index) const;
+
     public:
+        static constexpr uint64_t base_variant = 0;
+
         virtual ~Shader();
 
-        void Load(const std::string file_path);
+        // Load reads the file on a worker thread, the loader's when given.
+        // Link submits the program to the driver without waiting, status
+        // and reflection are resolved on the first Bind so several shaders
+        // can compile concurrently.
+        void Load(
+            const std::string file_path,
+            AssetLoader* loader = nullptr,
+            const LoadPriority priority = LoadPriority::IMMEDIATE);
+
+        void LoadCompute(
+            const std::string file_path,
+            AssetLoader* loader = nullptr,
+            const LoadPriority priority = LoadPriority::IMMEDIATE);
+
         void Link(const std::string additional_defines = "");
         void Delete();
 
+        const std::string& Path() const
+        {
+            return file_path;
+        }
+
+        // True for the shader file itself and anything it includes
+        bool DependsOn(
+            const std::string& changed_path) const;
+
+        // Declares the option axes, bit i of a variant mask adds
+        // "#define options[i]" on top of the Link defines.
+        void Options(
+            const std::vector<std::string> option_defines);
+
+        // Variants are identified by a hash of their complete define set.
+        // Registering one is cheap, it is compiled on Prewarm or first Bind.
+        uint64_t Variant(
+            const uint32_t option_mask);
+
+        // Not cacheable for define sets unlikely to recur, such as values
+        // baked in as constants, so they don't pile up in the program cache
+        uint64_t Variant(
+            const std::string& variant_defines,
+            const bool cacheable = true);
+
+        std::string OptionDefines(
+            const uint32_t option_mask) const;
+
+        void Prewarm(
+            const uint64_t variant);
+
+        bool Ready(
+            const uint64_t variant = base_variant) const;
+
+        void Evict(
+            const uint64_t variant);
+
+        // Links a submitted variant now, blocking until the driver is done
+        void Finish(
+            const uint64_t variant);
+
+        // Re-reads and relinks the source in the background. The new
+        // programs replace the current ones at a later Bind once all
+        // compiled variants have linked, a failure keeps the current ones.
+        void Reload();
+
         void Set(
             const Descriptor& descriptor,
             const uint32_t index);
 
         void Bind(
-            const uint32_t descriptor_set_index = 0);
+            const uint32_t descriptor_set_index = 0,
+            const uint64_t variant = base_variant);
     };
 }
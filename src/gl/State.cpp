@@ -0,0 +1,378 @@
+#include "State.hpp"
+
+#include <array>
+#include <optional>
+#include <unordered_map>
+
+namespace GL
+{
+    namespace State
+    {
+        constexpr size_t max_texture_units = 32;
+        constexpr size_t max_vertex_attribs = 16;
+
+        enum TextureTarget
+        {
+            TEXTURE_TARGET_2D,
+            TEXTURE_TARGET_2D_ARRAY,
+            TEXTURE_TARGET_3D,
+            TEXTURE_TARGET_CUBE_MAP,
+            TEXTURE_TARGET_COUNT
+        };
+
+        using TextureBindings = std::array<
+            std::optional<GLuint>, TEXTURE_TARGET_COUNT>;
+
+        struct Shadow
+        {
+            std::optional<GLuint> framebuffer;
+            std::optional<glm::ivec4> viewport;
+            std::optional<GLuint> program;
+            std::optional<GLenum> active_texture;
+            std::optional<GLenum> cull_face;
+            std::optional<GLenum> blend_equation;
+            std::optional<glm::uvec2> blend_func;
+            std::optional<glm::vec4> clear_color;
+
+            std::unordered_map<GLenum, GLuint> buffers;
+            std::unordered_map<uint64_t, GLuint> indexed_buffers;
+            std::unordered_map<GLenum, bool> capabilities;
+
+            std::array<TextureBindings, max_texture_units> textures;
+            std::array<bool, max_vertex_attribs> vertex_attribs{};
+        };
+
+        static Shadow shadow;
+        static Counters current;
+        static Counters previous;
+
+        template <typename T>
+        bool Changed(
+            std::optional<T>& cached,
+            const T value)
+        {
+            if (cached.has_value() && cached.value() == value)
+            {
+                current.elided++;
+                return false;
+            }
+
+            cached = value;
+            current.issued++;
+            return true;
+        }
+
+        template <typename K, typename T>
+        bool Changed(
+            std::unordered_map<K, T>& cached,
+            const K key,
+            const T value)
+        {
+            const auto it = cached.find(key);
+
+            if (it != cached.end() && it->second == value)
+            {
+                current.elided++;
+                return false;
+            }
+
+            cached[key] = value;
+            current.issued++;
+            return true;
+        }
+
+        size_t TextureTargetIndex(
+            const GLenum target)
+        {
+            switch (target)
+            {
+            case GL_TEXTURE_2D:
+                return TEXTURE_TARGET_2D;
+            case GL_TEXTURE_2D_ARRAY:
+                return TEXTURE_TARGET_2D_ARRAY;
+            case GL_TEXTURE_3D:
+                return TEXTURE_TARGET_3D;
+            case GL_TEXTURE_CUBE_MAP:
+                return TEXTURE_TARGET_CUBE_MAP;
+            }
+
+            return TEXTURE_TARGET_COUNT;
+        }
+
+        void Invalidate()
+        {
+            shadow = Shadow();
+        }
+
+        void NewFrame()
+        {
+            previous = current;
+            current = Counters();
+        }
+
+        const Counters& FrameCounters()
+        {
+            return previous;
+        }
+
+        void BindFramebuffer(
+            const GLuint framebuffer)
+        {
+            if (Changed(shadow.framebuffer, framebuffer))
+            {
+                glBindFramebuffer(
+                    GL_FRAMEBUFFER,
+                    framebuffer);
+            }
+        }
+
+        void Viewport(
+            const GLint x,
+            const GLint y,
+            const GLsizei width,
+            const GLsizei height)
+        {
+            if (Changed(shadow.viewport, glm::ivec4(x, y, width, height)))
+            {
+                glViewport(
+                    x,
+                    y,
+                    width,
+                    height);
+            }
+        }
+
+        void UseProgram(
+            const GLuint program)
+        {
+            if (Changed(shadow.program, program))
+            {
+                glUseProgram(
+                    program);
+            }
+        }
+
+        void BindBuffer(
+            const GLenum target,
+            const GLuint buffer)
+        {
+            if (Changed(shadow.buffers, target, buffer))
+            {
+                glBindBuffer(
+                    target,
+                    buffer);
+            }
+        }
+
+        void BindBufferBase(
+            const GLenum target,
+            const GLuint index,
+            const GLuint buffer)
+        {
+            const uint64_t key =
+                (static_cast<uint64_t>(target) << 32) | index;
+
+            if (Changed(shadow.indexed_buffers, key, buffer))
+            {
+                glBindBufferBase(
+                    target,
+                    index,
+                    buffer);
+
+                // Indexed binds also replace the generic binding point
+                shadow.buffers[target] = buffer;
+            }
+        }
+
+        void ActiveTexture(
+            const GLenum unit)
+        {
+            if (Changed(shadow.active_texture, unit))
+            {
+                glActiveTexture(
+                    unit);
+            }
+        }
+
+        void BindTexture(
+            const GLenum target,
+            const GLuint texture)
+        {
+            const size_t target_index = TextureTargetIndex(target);
+            const size_t unit = shadow.active_texture.has_value() ?
+                shadow.active_texture.value() - GL_TEXTURE0 :
+                max_texture_units;
+
+            if (target_index == TEXTURE_TARGET_COUNT ||
+                unit >= max_texture_units)
+            {
+                current.issued++;
+                glBindTexture(
+                    target,
+                    texture);
+                return;
+            }
+
+            if (Changed(shadow.textures[unit][target_index], texture))
+            {
+                glBindTexture(
+                    target,
+                    texture);
+            }
+        }
+
+        void Enable(
+            const GLenum capability)
+        {
+            if (Changed(shadow.capabilities, capability, true))
+            {
+                glEnable(
+                    capability);
+            }
+        }
+
+        void Disable(
+            const GLenum capability)
+        {
+            if (Changed(shadow.capabilities, capability, false))
+            {
+                glDisable(
+                    capability);
+            }
+        }
+
+        void CullFace(
+            const GLenum mode)
+        {
+            if (Changed(shadow.cull_face, mode))
+            {
+                glCullFace(
+                    mode);
+            }
+        }
+
+        void BlendEquation(
+            const GLenum mode)
+        {
+            if (Changed(shadow.blend_equation, mode))
+            {
+                glBlendEquation(
+                    mode);
+            }
+        }
+
+        void BlendFunc(
+            const GLenum source,
+            const GLenum destination)
+        {
+            if (Changed(shadow.blend_func, glm::uvec2(source, destination)))
+            {
+                glBlendFunc(
+                    source,
+                    destination);
+            }
+        }
+
+        void ClearColor(
+            const GLfloat r,
+            const GLfloat g,
+            const GLfloat b,
+            const GLfloat a)
+        {
+            if (Changed(shadow.clear_color, glm::vec4(r, g, b, a)))
+            {
+                glClearColor(
+                    r,
+                    g,
+                    b,
+                    a);
+            }
+        }
+
+        void EnableVertexAttribArray(
+            const GLuint index)
+        {
+            if (index < max_vertex_attribs && shadow.vertex_attribs[index])
+            {
+                current.elided++;
+                return;
+            }
+
+            if (index < max_vertex_attribs)
+            {
+                shadow.vertex_attribs[index] = true;
+            }
+
+            current.issued++;
+            glEnableVertexAttribArray(
+                index);
+        }
+
+        void DeleteFramebuffer(
+            const GLuint framebuffer)
+        {
+            if (shadow.framebuffer == framebuffer)
+            {
+                shadow.framebuffer = 0;
+            }
+
+            glDeleteFramebuffers(
+                1, &framebuffer);
+        }
+
+        void DeleteProgram(
+            const GLuint program)
+        {
+            // A bound program stays in use after deletion until another
+            // one is made current, so forget it rather than assume zero.
+            if (shadow.program == program)
+            {
+                shadow.program.reset();
+            }
+
+            glDeleteProgram(
+                program);
+        }
+
+        void DeleteBuffer(
+            const GLuint buffer)
+        {
+            for (auto& binding : shadow.buffers)
+            {
+                if (binding.second == buffer)
+                {
+                    binding.second = 0;
+                }
+            }
+
+            for (auto it = shadow.indexed_buffers.begin();
+                it != shadow.indexed_buffers.end();)
+            {
+                it = it->second == buffer ?
+                    shadow.indexed_buffers.erase(it) :
+                    std::next(it);
+            }
+
+            glDeleteBuffers(
+                1, &buffer);
+        }
+
+        void DeleteTexture(
+            const GLuint texture)
+        {
+            for (auto& unit : shadow.textures)
+            {
+                for (auto& binding : unit)
+                {
+                    if (binding == texture)
+                    {
+                        binding = 0;
+                    }
+                }
+            }
+
+            glDeleteTextures(
+                1, &texture);
+        }
+    }
+}
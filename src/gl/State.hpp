@@ -0,0 +1,91 @@
+#pragma once
+
+#include "OpenGL.hpp"
+
+namespace GL
+{
+    namespace State
+    {
+        struct Counters
+        {
+            uint32_t issued = 0;
+            uint32_t elided = 0;
+        };
+
+        // Forget all shadowed bindings, the next call of each kind is
+        // always issued. Use after foreign code touches the context.
+        void Invalidate();
+
+        // Ends the current frame, FrameCounters() then reports on it.
+        void NewFrame();
+
+        const Counters& FrameCounters();
+
+        void BindFramebuffer(
+            const GLuint framebuffer);
+
+        void Viewport(
+            const GLint x,
+            const GLint y,
+            const GLsizei width,
+            const GLsizei height);
+
+        void UseProgram(
+            const GLuint program);
+
+        void BindBuffer(
+            const GLenum target,
+            const GLuint buffer);
+
+        void BindBufferBase(
+            const GLenum target,
+            const GLuint index,
+            const GLuint buffer);
+
+        void ActiveTexture(
+            const GLenum unit);
+
+        void BindTexture(
+            const GLenum target,
+            const GLuint texture);
+
+        void Enable(
+            const GLenum capability);
+
+        void Disable(
+            const GLenum capability);
+
+        void CullFace(
+            const GLenum mode);
+
+        void BlendEquation(
+            const GLenum mode);
+
+        void BlendFunc(
+            const GLenum source,
+            const GLenum destination);
+
+        void ClearColor(
+            const GLfloat r,
+            const GLfloat g,
+            const GLfloat b,
+            const GLfloat a);
+
+        void EnableVertexAttribArray(
+            const GLuint index);
+
+        // Deleting a bound object implicitly unbinds it, and its name may
+        // be recycled, so deletes must go through the cache.
+        void DeleteFramebuffer(
+            const GLuint framebuffer);
+
+        void DeleteProgram(
+            const GLuint program);
+
+        void DeleteBuffer(
+            const GLuint buffer);
+
+        void DeleteTexture(
+            const GLuint texture);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "OpenGL.hpp"
+#include "State.hpp"
+
+#include <vector>
+
+// WebGL2 has no shader storage buffers
+#if !defined(EMSCRIPTEN)
+
+namespace GL
+{
+    // Array of std430 elements, T must match the GLSL struct layout.
+    // Storage is only reallocated when the element count grows, other
+    // updates go through glBufferSubData.
+    template <typename T>
+    class StorageBuffer : public GLBufferResource
+    {
+    private:
+        bool created = false;
+        size_t allocated_count = 0;
+
+    public:
+        std::vector<T> objects;
+
+        StorageBuffer()
+        {
+            glGenBuffers(
+                1, &gl_buffer_handle);
+        }
+
+        virtual ~StorageBuffer()
+        {
+            assert(!created);
+        }
+
+        void Delete()
+        {
+            if (created)
+            {
+                State::DeleteBuffer(
+                    gl_buffer_handle);
+            }
+
+            created = false;
+            allocated_count = 0;
+        }
+
+        void Update()
+        {
+            Update(
+                0,
+                objects.size());
+        }
+
+        // Uploads objects[first, first + count)
+        void Update(
+            const size_t first,
+            const size_t count)
+        {
+            assert(first + count <= objects.size());
+
+            created = true;
+
+            State::BindBuffer(
+                GL_SHADER_STORAGE_BUFFER,
+                gl_buffer_handle);
+
+            if (objects.size() > allocated_count)
+            {
+                glBufferData(
+                    GL_SHADER_STORAGE_BUFFER,
+                    objects.size() * sizeof(T),
+                    (void*)objects.data(),
+                    GL_DYNAMIC_DRAW);
+
+                allocated_count = objects.size();
+            }
+            else if (count > 0)
+            {
+                glBufferSubData(
+                    GL_SHADER_STORAGE_BUFFER,
+                    first * sizeof(T),
+                    count * sizeof(T),
+                    (void*)(objects.data() + first));
+            }
+
+            State::BindBuffer(
+                GL_SHADER_STORAGE_BUFFER,
+                0);
+        }
+    };
+}
+
+#endif
@@ -1,9 +1,19 @@
 #pragma once
 
 #include "OpenGL.hpp"
+#include "State.hpp"
 
-#include <vector>
+#include "../File.hpp"
+#include "../AssetLoader.hpp"
+
+#include <set>
 #include <array>
+#include <memory>
+#include <vector>
+#include <cstring>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
 
 #include <stb/stb_image.h>
 
@@ -24,22 +34,57 @@ enum class Wrap
     CLAMP_TO_EDGE
 };
 
+enum class Access
+{
+    READ_ONLY,
+    WRITE_ONLY,
+    READ_WRITE
+};
+
 namespace GL
 {
+    struct TextureOptions
+    {
+        // Allocates the full chain and regenerates it after each upload
+        bool mipmaps = true;
+
+        // Frees the CPU copy once uploaded, Data() is null afterwards and
+        // the texture can only change through another Load
+        bool keep_data = true;
+    };
+
+    struct TextureRect
+    {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // Storage is immutable and allocated on the first Update. Later
+    // updates only upload what was marked dirty since the last one, as
+    // one bounding rectangle per layer.
     template <typename T, size_t E = 1>
     class Texture2D : public GLTextureResource
     {
     private:
         bool created = false;
+        bool allocated = false;
 
-        uint32_t width;
-        uint32_t height;
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        TextureOptions options;
 
         GLuint gl_internal_format = GL_RGBA;
         GLuint gl_format = GL_RGBA;
         GLuint gl_type = GL_UNSIGNED_BYTE;
 
         std::array<std::unique_ptr<std::vector<T>>, E> data;
+        std::array<std::optional<TextureRect>, E> dirty;
+
+        static constexpr GLenum target =
+            E == 1 ? GL_TEXTURE_2D : GL_TEXTURE_2D_ARRAY;
 
         void SetFormat()
         {
@@ -61,9 +106,160 @@ namespace GL
             }
         };
 
+        GLsizei Levels() const
+        {
+            if (!options.mipmaps)
+            {
+                return 1;
+            }
+
+            GLsizei levels = 1;
+
+            for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+            {
+                levels++;
+            }
+
+            return levels;
+        }
+
+        void Allocate()
+        {
+            if (E == 1)
+            {
+                glTexStorage2D(
+                    GL_TEXTURE_2D,
+                    Levels(),
+                    gl_internal_format,
+                    width,
+                    height);
+            }
+            else
+            {
+                glTexStorage3D(
+                    GL_TEXTURE_2D_ARRAY,
+                    Levels(),
+                    gl_internal_format,
+                    width,
+                    height,
+                    E);
+            }
+
+            allocated = true;
+        }
+
+        // pixels points at the rect's first texel, or is an offset into
+        // the bound pixel unpack buffer
+        void Upload(
+            const size_t index,
+            const TextureRect& rect,
+            const GLvoid* pixels)
+        {
+            if (E == 1)
+            {
+                glTexSubImage2D(
+                    GL_TEXTURE_2D,
+                    0,
+                    rect.x,
+                    rect.y,
+                    rect.width,
+                    rect.height,
+                    gl_format,
+                    gl_type,
+                    pixels);
+            }
+            else
+            {
+                glTexSubImage3D(
+                    GL_TEXTURE_2D_ARRAY,
+                    0,
+                    rect.x,
+                    rect.y,
+                    static_cast<GLint>(index),
+                    rect.width,
+                    rect.height,
+                    1,
+                    gl_format,
+                    gl_type,
+                    pixels);
+            }
+        }
+
+        // Whole layer from a tightly packed source, outside Update's
+        // dirty tracking
+        void UploadLayer(
+            const size_t index,
+            const GLvoid* pixels)
+        {
+            State::ActiveTexture(
+                GL_TEXTURE0);
+
+            State::BindTexture(
+                target,
+                gl_texture_handle);
+
+            if (!allocated)
+            {
+                Allocate();
+            }
+
+            Upload(
+                index,
+                { 0, 0, width, height },
+                pixels);
+
+            GL::CheckError();
+
+            if (options.mipmaps)
+            {
+                glGenerateMipmap(
+                    target);
+            }
+
+            State::BindTexture(
+                target,
+                0);
+        }
+
+        // Returns true when a new texture object was made
+        bool CreateStorage(
+            const uint32_t width_,
+            const uint32_t height_)
+        {
+            // Immutable storage can't be resized, a new size needs a new
+            // texture object
+            if (created && (width_ != width || height_ != height))
+            {
+                Delete();
+            }
+
+            width = width_;
+            height = height_;
+
+            if (created)
+            {
+                return false;
+            }
+
+            created = true;
+            allocated = false;
+
+            SetFormat();
+
+            State::ActiveTexture(
+                GL_TEXTURE0);
+
+            glGenTextures(
+                1, &gl_texture_handle);
+
+            return true;
+        }
+
     public:
         Texture2D(
-            const std::string& file_path)
+            const std::string& file_path,
+            const TextureOptions options = {}) :
+            options(options)
         {
             Load(file_path);
             Update();
@@ -71,7 +267,9 @@ namespace GL
 
         Texture2D(
             const uint32_t width,
-            const uint32_t height)
+            const uint32_t height,
+            const TextureOptions options = {}) :
+            options(options)
         {
             Create(width, height);
         }
@@ -93,192 +291,478 @@ namespace GL
             assert(!created);
         }
 
+        // Writes through Data() need a MarkDirty before the next Update
         std::unique_ptr<std::vector<T>>& Data(
             size_t index = 0)
         {
             return data[index];
         };
 
+        void MarkDirty(
+            const size_t index = 0)
+        {
+            MarkDirty(
+                { 0, 0, width, height },
+                index);
+        }
+
+        void MarkDirty(
+            const TextureRect& rect,
+            const size_t index = 0)
+        {
+            assert(rect.x + rect.width <= width);
+            assert(rect.y + rect.height <= height);
+
+            if (rect.width == 0 || rect.height == 0)
+            {
+                return;
+            }
+
+            if (!dirty[index].has_value())
+            {
+                dirty[index] = rect;
+                return;
+            }
+
+            TextureRect& bounds = dirty[index].value();
+
+            const uint32_t right = std::max(
+                bounds.x + bounds.width,
+                rect.x + rect.width);
+
+            const uint32_t bottom = std::max(
+                bounds.y + bounds.height,
+                rect.y + rect.height);
+
+            bounds.x = std::min(bounds.x, rect.x);
+            bounds.y = std::min(bounds.y, rect.y);
+            bounds.width = right - bounds.x;
+            bounds.height = bottom - bounds.y;
+        }
+
+        void ReleaseData()
+        {
+            for (size_t i = 0; i < E; i++)
+            {
+                data[i].reset();
+            }
+        }
+
         void Create(
             const uint32_t width_,
             const uint32_t height_)
         {
-            created = true;
+            if (!CreateStorage(width_, height_))
+            {
+                return;
+            }
 
             for (size_t i = 0; i < E; i++)
             {
-                if (data[i] == nullptr)
+                if (data[i] == nullptr ||
+                    data[i]->size() != width * height)
                 {
                     data[i] = std::make_unique<std::vector<T>>(
-                        width_ * height_);
+                        width * height);
                 }
-            }
-
-            width = width_;
-            height = height_;
-
-            SetFormat();
 
-            glActiveTexture(
-                GL_TEXTURE0);
-
-            glGenTextures(
-                1, &gl_texture_handle);
+                MarkDirty(
+                    i);
+            }
         };
 
         void Update()
         {
-            glActiveTexture(
+            State::ActiveTexture(
                 GL_TEXTURE0);
 
-            if (E == 1)
+            State::BindTexture(
+                target,
+                gl_texture_handle);
+
+            if (!allocated)
             {
-                glBindTexture(
-                    GL_TEXTURE_2D,
-                    gl_texture_handle);
+                Allocate();
+            }
 
-                glTexImage2D(
-                    GL_TEXTURE_2D,
-                    0, // TODO mipmaps parameter
-                    gl_internal_format,
-                    width,
-                    height,
-                    0,
-                    gl_format,
-                    gl_type,
-                    (GLvoid*)&((*data[0])[0]));
+            // Sub-rectangles are read straight out of the full-width rows
+            glPixelStorei(
+                GL_UNPACK_ROW_LENGTH,
+                width);
 
-                glGenerateMipmap(
-                    GL_TEXTURE_2D);
+            bool uploaded = false;
 
-                glBindTexture(
-                    GL_TEXTURE_2D,
-                    NULL);
-            }
-            else
+            for (size_t i = 0; i < E; i++)
             {
-                glBindTexture(
-                    GL_TEXTURE_2D_ARRAY,
-                    gl_texture_handle);
+                if (dirty[i].has_value())
+                {
+                    if (data[i] == nullptr)
+                    {
+                        throw std::runtime_error(
+                            "Texture layer marked dirty after its data was released");
+                    }
 
-                glTexStorage3D(
-                    GL_TEXTURE_2D_ARRAY,
-                    1, // TODO mipmaps parameter
-                    gl_internal_format,
-                    width,
-                    height,
-                    E);
+                    const TextureRect& rect = dirty[i].value();
 
-                for (uint32_t i = 0; i < E; i++)
-                {
-                    glTexSubImage3D(
-                        GL_TEXTURE_2D_ARRAY,
-                        0,
-                        0,
-                        0,
+                    Upload(
                         i,
-                        width,
-                        height,
-                        1,
-                        gl_format,
-                        gl_type,
-                        (GLvoid*)&((*data[i])[0]));
+                        rect,
+                        data[i]->data() + rect.y * width + rect.x);
+
+                    dirty[i].reset();
+                    uploaded = true;
                 }
+            }
 
-                GL::CheckError();
+            glPixelStorei(
+                GL_UNPACK_ROW_LENGTH,
+                0);
 
+            GL::CheckError();
+
+            if (uploaded && options.mipmaps)
+            {
                 glGenerateMipmap(
-                    GL_TEXTURE_2D_ARRAY);
+                    target);
+            }
 
-                glBindTexture(
-                    GL_TEXTURE_2D_ARRAY,
-                    NULL);
+            State::BindTexture(
+                target,
+                0);
+
+            if (!options.keep_data)
+            {
+                ReleaseData();
             }
         }
 
-        void Load(
-            const std::string file,
-            const size_t index = 0)
+        struct Decoded
         {
+            uint32_t width = 0;
+            uint32_t height = 0;
+
+            // stb_image's own allocation, decoded texels are never copied
+            // on their way to a staging buffer
+            std::shared_ptr<T> pixels;
+        };
+
+        // No GL calls, safe on loader threads
+        static Decoded Decode(
+            const std::string& file)
+        {
+            Decoded decoded;
+
 #if !defined(EMSCRIPTEN)
+            // Decoded from the mapping, stdio would copy the file first
+            const MappedFile encoded(file);
+
+            int t_width, t_height, t_channels;
+            T* raw_data = nullptr;
+
             if      constexpr (std::is_same_v<T, TexDataByteRGBA>)
             {
-                int t_width, t_height, t_channels;
-
-                const auto* loaded = stbi_load(
-                    file.c_str(),
+                raw_data = reinterpret_cast<T*>(stbi_load_from_memory(
+                    encoded.Data(),
+                    static_cast<int>(encoded.Length()),
                     &t_width,
                     &t_height,
                     &t_channels,
-                    STBI_rgb_alpha);
+                    STBI_rgb_alpha));
+            }
+            else if constexpr (std::is_same_v<T, TexDataFloatRGBA>)
+            {
+                raw_data = reinterpret_cast<T*>(stbi_loadf_from_memory(
+                    encoded.Data(),
+                    static_cast<int>(encoded.Length()),
+                    &t_width,
+                    &t_height,
+                    &t_channels,
+                    STBI_rgb_alpha));
+            }
+            else
+            {
+                assert(false);
+            }
+
+            if (raw_data == nullptr)
+            {
+                throw std::runtime_error(
+                    "Failed to decode image: " + file);
+            }
 
-                const auto* raw_data = reinterpret_cast<TexDataByteRGBA*>(
-                    loaded);
+            decoded.width = t_width;
+            decoded.height = t_height;
+            decoded.pixels = std::shared_ptr<T>(
+                raw_data,
+                [](T* pixels) {
+                    stbi_image_free(pixels);
+                });
+#endif
 
-                const size_t raw_data_size =
-                    t_width * t_height;
+            return decoded;
+        }
 
-                data[index] = std::make_unique<std::vector<TexDataByteRGBA>>(
-                    raw_data_size);
+        // With keep_data the texels are copied once into Data(), without
+        // it they are uploaded straight from the decoded buffer.
+        void Load(
+            Decoded& decoded,
+            const size_t index = 0)
+        {
+            if (decoded.pixels == nullptr)
+            {
+                return;
+            }
 
-                data[index]->assign(
-                    raw_data,
-                    raw_data + raw_data_size);
+            if (!options.keep_data)
+            {
+                CreateStorage(
+                    decoded.width,
+                    decoded.height);
 
-                stbi_image_free(
-                    raw_data);
+                UploadLayer(
+                    index,
+                    decoded.pixels.get());
 
-                Create(
-                    t_width,
-                    t_height);
+                decoded.pixels.reset();
+                return;
             }
-            else if constexpr (std::is_same_v<T, TexDataFloatRGBA>)
-            {
-                int t_width, t_height, t_channels;
 
-                const auto* loaded = stbi_loadf(
-                    file.c_str(),
-                    &t_width,
-                    &t_height,
-                    &t_channels,
-                    STBI_rgb_alpha);
+            const T* pixels = decoded.pixels.get();
 
-                const auto* raw_data = reinterpret_cast<TexDataFloatRGBA*>(
-                    loaded);
+            data[index] = std::make_unique<std::vector<T>>(
+                pixels,
+                pixels + static_cast<size_t>(decoded.width) * decoded.height);
 
-                const size_t raw_data_size =
-                    t_width * t_height;
+            decoded.pixels.reset();
 
-                data[index] = std::make_unique<std::vector<TexDataFloatRGBA>>(
-                    raw_data_size);
+            Create(
+                decoded.width,
+                decoded.height);
 
-                data[index]->assign(
-                    raw_data,
-                    raw_data + raw_data_size);
+            MarkDirty(
+                index);
+        }
 
-                stbi_image_free(
-                    raw_data);
+        void Load(
+            const std::string file,
+            const size_t index = 0)
+        {
+            Decoded decoded = Decode(
+                file);
 
-                Create(
-                    t_width,
-                    t_height);
-            }
-            else
-            {
-                assert(false);
-            }
+            Load(
+                decoded,
+                index);
+        }
+
+        // Decodes on a loader thread, several loads decode in parallel.
+        // Without keep_data the texels are then copied into a mapped
+        // pixel unpack buffer on a loader thread as well, and loaded runs
+        // once that upload was issued. Cancel the handle before deleting
+        // the texture, Delete waits for staging copies itself.
+        LoadHandle LoadAsync(
+            AssetLoader& loader,
+            const std::string file,
+            const size_t index = 0,
+            const LoadPriority priority = LoadPriority::IMMEDIATE,
+            std::function<void()> loaded = nullptr)
+        {
+            return loader.Request<Decoded>(
+                [file]() {
+                    return Decode(file);
+                },
+                [this, &loader, index, priority, loaded](Decoded& decoded) {
+#if !defined(EMSCRIPTEN)
+                    if (!options.keep_data)
+                    {
+                        Stage(
+                            loader,
+                            decoded,
+                            index,
+                            priority,
+                            loaded);
+
+                        return;
+                    }
 #endif
+
+                    Load(
+                        decoded,
+                        index);
+
+                    Update();
+
+                    if (loaded != nullptr)
+                    {
+                        loaded();
+                    }
+                },
+                priority);
         }
 
         void Delete()
         {
+#if !defined(EMSCRIPTEN)
+            // Mapped buffers have to be unmapped by their completion
+            while (!staging_loads.empty())
+            {
+                const LoadHandle handle = *staging_loads.begin();
+
+                staging_loader->Wait(
+                    handle);
+
+                staging_loads.erase(
+                    handle);
+            }
+#endif
+
             if (created)
             {
-                glDeleteTextures(
-                    1, &gl_texture_handle);
+                State::DeleteTexture(
+                    gl_texture_handle);
             }
 
             created = false;
+            allocated = false;
+
+            for (auto& rect : dirty)
+            {
+                rect.reset();
+            }
+        }
+
+    private:
+#if !defined(EMSCRIPTEN)
+        // Pixel unpack buffer mapped on the main thread and filled by a
+        // loader thread, so the driver copies to the GPU asynchronously
+        // instead of from client memory inside glTexSubImage.
+        struct Staging
+        {
+            GLuint buffer = 0;
+            void* mapped = nullptr;
+            size_t size = 0;
+            std::shared_ptr<T> pixels;
+        };
+
+        AssetLoader* staging_loader = nullptr;
+        std::set<LoadHandle> staging_loads;
+
+        void FinishStaging(
+            Staging& staging,
+            const size_t index,
+            const LoadHandle handle,
+            std::function<void()> loaded)
+        {
+            staging_loads.erase(handle);
+
+            State::BindBuffer(
+                GL_PIXEL_UNPACK_BUFFER,
+                staging.buffer);
+
+            glUnmapBuffer(
+                GL_PIXEL_UNPACK_BUFFER);
+
+            UploadLayer(
+                index,
+                nullptr);
+
+            State::BindBuffer(
+                GL_PIXEL_UNPACK_BUFFER,
+                0);
+
+            // The driver keeps the storage until the copy has finished
+            State::DeleteBuffer(
+                staging.buffer);
+
+            if (loaded != nullptr)
+            {
+                loaded();
+            }
         }
+
+        void Stage(
+            AssetLoader& loader,
+            Decoded& decoded,
+            const size_t index,
+            const LoadPriority priority,
+            std::function<void()> loaded)
+        {
+            CreateStorage(
+                decoded.width,
+                decoded.height);
+
+            Staging staging;
+            staging.size = static_cast<size_t>(width) * height * sizeof(T);
+            staging.pixels = std::move(decoded.pixels);
+
+            glGenBuffers(
+                1, &staging.buffer);
+
+            State::BindBuffer(
+                GL_PIXEL_UNPACK_BUFFER,
+                staging.buffer);
+
+            glBufferData(
+                GL_PIXEL_UNPACK_BUFFER,
+                staging.size,
+                nullptr,
+                GL_STREAM_DRAW);
+
+            staging.mapped = glMapBufferRange(
+                GL_PIXEL_UNPACK_BUFFER,
+                0,
+                staging.size,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+            State::BindBuffer(
+                GL_PIXEL_UNPACK_BUFFER,
+                0);
+
+            if (staging.mapped == nullptr)
+            {
+                State::DeleteBuffer(
+                    staging.buffer);
+
+                UploadLayer(
+                    index,
+                    staging.pixels.get());
+
+                if (loaded != nullptr)
+                {
+                    loaded();
+                }
+
+                return;
+            }
+
+            staging_loader = &loader;
+
+            // The handle isn't known until Request returns
+            auto handle = std::make_shared<LoadHandle>(0);
+
+            *handle = loader.Request<Staging>(
+                [staging = std::move(staging)]() mutable {
+                    std::memcpy(
+                        staging.mapped,
+                        staging.pixels.get(),
+                        staging.size);
+
+                    // The job holds the only reference, stb's buffer is
+                    // freed here as soon as the mapping has its copy
+                    staging.pixels.reset();
+                    return staging;
+                },
+                [this, index, handle, loaded](Staging& copied) {
+                    FinishStaging(
+                        copied,
+                        index,
+                        *handle,
+                        loaded);
+                },
+                priority);
+
+            staging_loads.insert(*handle);
+        }
+#endif
     };
 }
\ No newline at end of file
@@ -1,15 +1,26 @@
 #pragma once
 
 #include "OpenGL.hpp"
+#include "State.hpp"
+
+#include "../DirtySpan.hpp"
+
+#include <cstring>
+#include <stdexcept>
 
 namespace GL
 {
+    // T provides a static Layout() naming each member the shader reads.
+    // object is the staging copy, Update uploads the span written through
+    // Set, a bound Properties::Property or MarkDirty since the last one.
     template <typename T>
     class UniformBuffer : public GLBufferResource
     {
     private:
         bool created = false;
 
+        DirtySpan dirty;
+
     public:
         T object;
 
@@ -18,43 +29,119 @@ namespace GL
             // Must be padded to 16 byte multiples
             assert(sizeof(T) % 16 == 0);
 
-            glGenBuffers(
-                1, &gl_buffer_handle);
+            layout = &T::Layout();
+
+            dirty.base = reinterpret_cast<const uint8_t*>(&object);
+
+            Create();
         }
 
+        // The span points into object
+        UniformBuffer(const UniformBuffer<T>&) = delete;
+
         virtual ~UniformBuffer()
         {
             assert(!created);
         }
 
+        // Names a new buffer after Delete. Descriptors hold the name, so
+        // set the block on them again afterwards. Bindings into object
+        // survive, the next Update uploads all of it.
+        void Create()
+        {
+            if (gl_buffer_handle != 0)
+            {
+                return;
+            }
+
+            glGenBuffers(
+                1, &gl_buffer_handle);
+        }
+
         void Delete()
         {
-            if (created)
+            if (gl_buffer_handle != 0)
             {
-                glDeleteBuffers(
-                    1, &gl_buffer_handle);
+                State::DeleteBuffer(
+                    gl_buffer_handle);
+
+                gl_buffer_handle = 0;
             }
 
             created = false;
         }
 
+        DirtySpan& Dirty()
+        {
+            return dirty;
+        }
+
+        // For writes made straight into object
+        void MarkDirty()
+        {
+            dirty.Mark(
+                &object,
+                sizeof(T));
+        }
+
+        // field is a member of object, marked only if the value changes
+        template <typename M>
+        void Set(
+            M& field,
+            const M& value)
+        {
+            if (std::memcmp(&field, &value, sizeof(M)) == 0)
+            {
+                return;
+            }
+
+            field = value;
+
+            dirty.Mark(
+                &field,
+                sizeof(M));
+        }
+
         void Update()
         {
-            created = true;
+            if (created && dirty.Empty())
+            {
+                return;
+            }
 
-            glBindBuffer(
+            if (gl_buffer_handle == 0)
+            {
+                throw std::runtime_error(
+                    "Uniform buffer updated after Delete, Create it first");
+            }
+
+            State::BindBuffer(
                 GL_UNIFORM_BUFFER,
                 gl_buffer_handle);
 
-            glBufferData(
-                GL_UNIFORM_BUFFER,
-                sizeof(T),
-                (void*)&object,
-                GL_DYNAMIC_DRAW);
+            if (!created)
+            {
+                glBufferData(
+                    GL_UNIFORM_BUFFER,
+                    sizeof(T),
+                    (void*)&object,
+                    GL_DYNAMIC_DRAW);
+            }
+            else
+            {
+                glBufferSubData(
+                    GL_UNIFORM_BUFFER,
+                    dirty.begin,
+                    dirty.end - dirty.begin,
+                    dirty.base + dirty.begin);
+            }
 
-            glBindBuffer(
+            State::BindBuffer(
                 GL_UNIFORM_BUFFER,
                 0);
+
+            created = true;
+            dirty.Clear();
         }
     };
 }
@@ -0,0 +1,42 @@
+#include "UniformId.hpp"
+
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace GL
+{
+    static std::mutex intern_mutex;
+
+    // Node based, so the interned strings never move
+    static std::unordered_map<uint64_t, std::string> interned;
+
+    UniformId UniformId::Intern(
+        const std::string_view name)
+    {
+        const uint64_t hash = hash_fnv1a(
+            name);
+
+        std::lock_guard<std::mutex> lock(intern_mutex);
+
+        auto it = interned.find(hash);
+
+        if (it == interned.end())
+        {
+            it = interned.emplace(
+                hash,
+                std::string(name)).first;
+        }
+
+        if (it->second != name)
+        {
+            throw std::runtime_error(
+                "Uniform names " + it->second + " and " +
+                std::string(name) + " share a hash");
+        }
+
+        return UniformId(
+            hash,
+            it->second);
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../Hash.hpp"
+
+#include <tuple>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+#include <string_view>
+
+namespace GL
+{
+    // Uniform name identified by its hash. Literals hash at compile time
+    // and keep pointing at their static storage, names only known at
+    // runtime are interned so the view outlives the string it came from.
+    class UniformId
+    {
+    private:
+        uint64_t hash;
+        std::string_view name;
+
+        constexpr UniformId(
+            const uint64_t hash,
+            const std::string_view name) :
+            hash(hash),
+            name(name)
+        {
+        }
+
+    public:
+        template <size_t N>
+        constexpr UniformId(const char (&literal)[N]) :
+            hash(hash_fnv1a(std::string_view(literal, N - 1))),
+            name(literal, N - 1)
+        {
+        }
+
+        // Throws when two different names share a hash
+        static UniformId Intern(
+            const std::string_view name);
+
+        constexpr uint64_t Hash() const
+        {
+            return hash;
+        }
+
+        constexpr std::string_view Name() const
+        {
+            return name;
+        }
+
+        constexpr bool operator==(const UniformId& other) const
+        {
+            return hash == other.hash;
+        }
+
+        constexpr bool operator<(const UniformId& other) const
+        {
+            return hash < other.hash;
+        }
+    };
+
+    // Flat array sorted by id. Set reuses the slot of an existing id, so
+    // refilling a table with the same names doesn't allocate.
+    template <typename T>
+    class UniformTable
+    {
+    public:
+        using Entry = std::tuple<UniformId, T>;
+
+    private:
+        std::vector<Entry> entries;
+
+        static bool Less(
+            const Entry& entry,
+            const UniformId& id)
+        {
+            return std::get<0>(entry) < id;
+        }
+
+    public:
+        void Set(
+            const UniformId id,
+            const T& value)
+        {
+            const auto it = std::lower_bound(
+                entries.begin(),
+                entries.end(),
+                id,
+                Less);
+
+            if (it != entries.end() && std::get<0>(*it) == id)
+            {
+                std::get<1>(*it) = value;
+                return;
+            }
+
+            entries.insert(
+                it,
+                Entry(id, value));
+        }
+
+        const T* Find(
+            const UniformId id) const
+        {
+            const auto it = std::lower_bound(
+                entries.begin(),
+                entries.end(),
+                id,
+                Less);
+
+            if (it == entries.end() || !(std::get<0>(*it) == id))
+            {
+                return nullptr;
+            }
+
+            return &std::get<1>(*it);
+        }
+
+        void Clear()
+        {
+            entries.clear();
+        }
+
+        size_t Size() const
+        {
+            return entries.size();
+        }
+
+        typename std::vector<Entry>::const_iterator begin() const
+        {
+            return entries.begin();
+        }
+
+        typename std::vector<Entry>::const_iterator end() const
+        {
+            return entries.end();
+        }
+    };
+}
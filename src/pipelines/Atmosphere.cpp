@@ -1,5 +1,8 @@
 #include "Atmosphere.hpp"
 
+#include <limits>
+#include <cstring>
+#include <iomanip>
 #include <sstream>
 #include <algorithm>
 
@@ -9,14 +12,32 @@ namespace Pipelines
     {
     }
 
-    void Atmosphere::Init()
+    void Atmosphere::Init(
+        AssetLoader& loader)
     {
-        frontbuffer_shader.Load("files/gl/frontbuffer.glsl");
-        atmosphere_shader.Load("files/gl/atmosphere.glsl");
+        frontbuffer_shader.Load("files/gl/frontbuffer.glsl", &loader);
+        atmosphere_shader.Load("files/gl/atmosphere.glsl", &loader);
 
         frontbuffer_shader.Link();
         atmosphere_shader.Link();
 
+        // Bit order matches AtmosphereOption
+        atmosphere_shader.Options({
+            "ATMOSPHERE_LOW_STEPS"
+        });
+
+        atmosphere_shader.Prewarm(
+            atmosphere_shader.Variant(ATMOSPHERE_OPTION_LOW_STEPS));
+
+        if (ComputeSupported())
+        {
+            // Only linked by InitAtmosphere, behind the fragment shaders
+            atmosphere_compute_shader.LoadCompute(
+                "files/gl/atmosphere_compute.glsl",
+                &loader,
+                LoadPriority::PREFETCH);
+        }
+
         camera_uniforms =
             std::make_unique<UniformBuffer<CameraUniforms>>();
     }
@@ -27,6 +48,8 @@ namespace Pipelines
 
         frontbuffer_shader.Delete();
         atmosphere_shader.Delete();
+        atmosphere_compute_shader.Delete();
+        compute_linked = false;
     }
 
     void Atmosphere::InitAtmosphere(
@@ -41,11 +64,17 @@ namespace Pipelines
             framebuffer_height,
             true);
 
-        camera_uniforms =
-            std::make_unique<UniformBuffer<CameraUniforms>>();
+        // Kept across resizes, properties stay bound to their fields.
+        // DeinitAtmosphere deleted their buffers, the sets below take
+        // the new names.
+        if (atmosphere_uniforms == nullptr)
+        {
+            atmosphere_uniforms =
+                std::make_unique<UniformBuffer<AtmosphereUniforms>>();
+        }
 
-        atmosphere_uniforms =
-            std::make_unique<UniformBuffer<AtmosphereUniforms>>();
+        camera_uniforms->Create();
+        atmosphere_uniforms->Create();
 
         framebuffer =
             std::make_unique<FrameBuffer<TexDataFloatRGBA>>();
@@ -90,6 +119,45 @@ namespace Pipelines
         atmosphere_shader.Set(
             atmosphere_set_0,
             0);
+
+        if (!ComputeSupported())
+        {
+            return;
+        }
+
+        // Linked on the first init, once the target size is known
+        if (!compute_linked)
+        {
+            compute_linked = true;
+
+            atmosphere_workgroup = SelectWorkgroupSize(
+                framebuffer_width,
+                framebuffer_height);
+
+            atmosphere_compute_shader.Link(
+                atmosphere_workgroup.Defines());
+
+            atmosphere_compute_shader.Options({
+                "ATMOSPHERE_LOW_STEPS"
+            });
+        }
+
+        atmosphere_compute_set_0.SetUniformBlock(
+            "camera",
+            *camera_uniforms);
+
+        atmosphere_compute_set_0.SetUniformBlock(
+            "atmosphere",
+            *atmosphere_uniforms);
+
+        atmosphere_compute_set_0.SetImage2D(
+            "atmosphere_image",
+            *framebuffer,
+            Access::WRITE_ONLY);
+
+        atmosphere_compute_shader.Set(
+            atmosphere_compute_set_0,
+            0);
     }
 
     void Atmosphere::DeinitAtmosphere()
@@ -115,6 +183,134 @@ namespace Pipelines
     {
     }
 
+    void Atmosphere::ReloadShaders(
+        const std::vector<std::string>& changed_files)
+    {
+        for (const auto& file : changed_files)
+        {
+            for (Shader* shader : {
+                &frontbuffer_shader,
+                &atmosphere_shader,
+                &atmosphere_compute_shader })
+            {
+                if (shader->DependsOn(file))
+                {
+                    shader->Reload();
+                }
+            }
+        }
+    }
+
+    std::string Atmosphere::FrozenDefines() const
+    {
+        const AtmosphereUniforms& u = frozen_uniforms;
+
+        std::stringstream defines;
+        defines << std::showpoint << std::setprecision(
+            std::numeric_limits<float>::max_digits10);
+
+        const auto Define = [&](const char* name, const float value) {
+            defines << "#define " << name << " " << value << std::endl;
+        };
+
+        defines << "#define ATMOSPHERE_FROZEN" << std::endl;
+
+        Define("rayleigh_brightness_uniform", u.rayleigh_brightness_uniform);
+        Define("mie_brightness_uniform", u.mie_brightness_uniform);
+        Define("spot_brightness_uniform", u.spot_brightness_uniform);
+        Define("scatter_strength_uniform", u.scatter_strength_uniform);
+        Define("rayleigh_strength_uniform", u.rayleigh_strength_uniform);
+        Define("mie_strength_uniform", u.mie_strength_uniform);
+        Define("rayleigh_collection_power_uniform", u.rayleigh_collection_power_uniform);
+        Define("mie_collection_power_uniform", u.mie_collection_power_uniform);
+        Define("mie_distribution_uniform", u.mie_distribution_uniform);
+        Define("elevation_uniform", u.elevation_uniform);
+
+        defines << "#define Kr vec4(" <<
+            u.kr.r << ", " <<
+            u.kr.g << ", " <<
+            u.kr.b << ", " <<
+            u.kr.a << ")" << std::endl;
+
+        return defines.str();
+    }
+
+    uint64_t Atmosphere::UpdateFrozen(
+        Shader& shader)
+    {
+        const uint64_t generic_variant =
+            shader.Variant(atmosphere_options);
+
+        const bool changed =
+            &shader != frozen_shader ||
+            atmosphere_options != frozen_options ||
+            std::memcmp(
+                &atmosphere_uniforms->object,
+                &frozen_uniforms,
+                sizeof(AtmosphereUniforms)) != 0;
+
+        if (changed || !freeze_enabled)
+        {
+            // Fall back to the generic program straight away, the
+            // specialisation is stale and is rebuilt once stable again.
+            if (frozen_variant.has_value())
+            {
+                frozen_shader->Evict(
+                    frozen_variant.value());
+
+                frozen_variant.reset();
+            }
+
+            frozen_ready = false;
+
+            frozen_uniforms = atmosphere_uniforms->object;
+            frozen_options = atmosphere_options;
+            frozen_shader = &shader;
+            stable_frames = 0;
+
+            return generic_variant;
+        }
+
+        stable_frames++;
+
+        if (stable_frames == frozen_after_frames)
+        {
+            // Every slider setting is a new define set, kept out of the
+            // program cache so it doesn't grow across sessions
+            frozen_variant = shader.Variant(
+                shader.OptionDefines(atmosphere_options) +
+                FrozenDefines(),
+                false);
+
+            shader.Prewarm(
+                frozen_variant.value());
+        }
+
+        if (frozen_variant.has_value() && !frozen_ready)
+        {
+            if (ParallelCompileSupported())
+            {
+                frozen_ready = shader.Ready(
+                    frozen_variant.value());
+            }
+            else if (stable_frames == frozen_after_frames + frozen_finish_frames)
+            {
+                // Nothing reports progress without KHR_parallel_shader_compile,
+                // the link status query blocks until the driver is done. Take
+                // that wait once, late enough that a driver compiling on its
+                // own threads has usually finished.
+                shader.Finish(
+                    frozen_variant.value());
+
+                frozen_ready = true;
+            }
+        }
+
+        return frozen_ready ?
+            frozen_variant.value() :
+            generic_variant;
+    }
+
     void Atmosphere::Draw(
         const std::unique_ptr<Camera>& camera,
         const glm::mat4 projection_,
@@ -124,25 +320,61 @@ namespace Pipelines
         projection = projection_;
         view = view_;
 
-        // Draw to FBO
-
-        framebuffer->Bind();
-
         camera->Validate();
-        camera_uniforms->object.view =
-            camera->View();
-        camera_uniforms->object.projection =
-            camera->Projection();
-        camera_uniforms->object.viewport =
-            camera->viewport;
-        camera_uniforms->object.position = glm::vec4(
-            camera->position, 1.0f);
+        camera_uniforms->Set(
+            camera_uniforms->object.view,
+            camera->View());
+        camera_uniforms->Set(
+            camera_uniforms->object.projection,
+            camera->Projection());
+        camera_uniforms->Set(
+            camera_uniforms->object.viewport,
+            camera->viewport);
+        camera_uniforms->Set(
+            camera_uniforms->object.position,
+            glm::vec4(camera->position, 1.0f));
+
+        // Nothing to upload while the camera is still
         camera_uniforms->Update();
 
-        atmosphere_uniforms->Update();
+        Shader& sky_shader = UsingCompute() ?
+            atmosphere_compute_shader :
+            atmosphere_shader;
 
-        DrawQuad(
-            atmosphere_shader);
+        const uint64_t atmosphere_variant = UpdateFrozen(
+            sky_shader);
+
+        // The frozen program has no atmosphere block to upload to
+        if (!Frozen())
+        {
+            atmosphere_uniforms->Update();
+        }
+
+#if !defined(EMSCRIPTEN)
+        if (UsingCompute())
+        {
+            Dispatch(
+                atmosphere_compute_shader,
+                atmosphere_workgroup,
+                framebuffer->Width(),
+                framebuffer->Height(),
+                atmosphere_variant);
+
+            // The front buffer pass samples what the dispatch wrote
+            Barrier(
+                GL_TEXTURE_FETCH_BARRIER_BIT);
+        }
+        else
+#endif
+        {
+            // Draw to FBO
+
+            framebuffer->Bind();
+
+            DrawQuad(
+                atmosphere_shader,
+                atmosphere_variant);
+        }
 
         // Render to front buffer
 
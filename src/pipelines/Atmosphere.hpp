@@ -8,18 +8,13 @@
 #include "../math/Math.hpp"
 
 #include <memory>
+#include <cstddef>
+#include <string>
+#include <optional>
+#include <vector>
 
 namespace Pipelines
 {
-    struct CameraUniforms
-    {
-        glm::mat4 view;
-        glm::mat4 projection;
-        glm::vec4 viewport;
-        glm::vec4 position;
-        glm::vec4 exposure;
-    };
-
     struct AtmosphereUniforms
     {
         float rayleigh_brightness_uniform = 64.0;
@@ -32,6 +27,8 @@ namespace Pipelines
         float mie_collection_power_uniform = 39.0;
         float mie_distribution_uniform = 63.0;
         float elevation_uniform = 1.0;
+        // std140 aligns Kr to 16 bytes, spelled out so UpdateFrozen's
+        // memcmp never compares indeterminate padding
         float padding_1 = 0.0;
         float padding_2 = 0.0;
         glm::vec4 kr = glm::vec4(
@@ -39,13 +36,44 @@ namespace Pipelines
             0.4978442963618773,
             0.6616065586417131,
             1.0);
+
+        static const UniformLayout& Layout()
+        {
+            using U = AtmosphereUniforms;
+
+            static const UniformLayout layout = {
+                sizeof(U),
+                {
+                    { "rayleigh_brightness_uniform", offsetof(U, rayleigh_brightness_uniform) },
+                    { "mie_brightness_uniform", offsetof(U, mie_brightness_uniform) },
+                    { "spot_brightness_uniform", offsetof(U, spot_brightness_uniform) },
+                    { "scatter_strength_uniform", offsetof(U, scatter_strength_uniform) },
+                    { "rayleigh_strength_uniform", offsetof(U, rayleigh_strength_uniform) },
+                    { "mie_strength_uniform", offsetof(U, mie_strength_uniform) },
+                    { "rayleigh_collection_power_uniform", offsetof(U, rayleigh_collection_power_uniform) },
+                    { "mie_collection_power_uniform", offsetof(U, mie_collection_power_uniform) },
+                    { "mie_distribution_uniform", offsetof(U, mie_distribution_uniform) },
+                    { "elevation_uniform", offsetof(U, elevation_uniform) },
+                    { "Kr", offsetof(U, kr) }
+                }
+            };
+
+            return layout;
+        }
     };
 
-    class Atmosphere : public Pipeline
+    enum AtmosphereOption : uint32_t
+    {
+        ATMOSPHERE_OPTION_LOW_STEPS = 1 << 0
+    };
+
+    class Atmosphere : public Pipeline, public ComputePipeline
     {
     private:
         bool initialized = false;
 
+        uint32_t atmosphere_options = 0;
+
         float exposure = 1.0f;
 
         glm::mat4 view;
@@ -59,13 +87,41 @@ namespace Pipelines
 
         Shader frontbuffer_shader;
         Shader atmosphere_shader;
+        Shader atmosphere_compute_shader;
 
         Descriptor frontbuffer_set_0;
         Descriptor atmosphere_set_0;
+        Descriptor atmosphere_compute_set_0;
+
+        // Evaluates the sky with a dispatch writing the framebuffer texture
+        // directly, when the context has compute shaders.
+        bool compute_enabled = true;
+        bool compute_linked = false;
+        WorkgroupSize atmosphere_workgroup;
+
+        // Frozen specialisation, atmosphere parameters baked as literals
+        // once they have been stable for frozen_after_frames frames. Drivers
+        // without parallel compile finish it frozen_finish_frames later.
+        bool freeze_enabled = true;
+        bool frozen_ready = false;
+        uint32_t frozen_after_frames = 120;
+        uint32_t frozen_finish_frames = 30;
+        uint32_t stable_frames = 0;
+        uint32_t frozen_options = 0;
+        AtmosphereUniforms frozen_uniforms;
+        std::optional<uint64_t> frozen_variant;
+        Shader* frozen_shader = nullptr;
+
+        std::string FrozenDefines() const;
+
+        uint64_t UpdateFrozen(
+            Shader& shader);
+
     public:
         Atmosphere();
 
-        void Init();
+        void Init(
+            AssetLoader& loader);
 
         void InitAtmosphere(
             const uint32_t framebuffer_width,
@@ -77,6 +133,9 @@ namespace Pipelines
 
         void Update();
 
+        void ReloadShaders(
+            const std::vector<std::string>& changed_files);
+
         void Draw(
             const std::unique_ptr<Camera>& camera,
             const glm::mat4 projection,
@@ -87,5 +146,32 @@ namespace Pipelines
         {
             return atmosphere_uniforms;
         }
+
+        uint32_t& options()
+        {
+            return atmosphere_options;
+        }
+
+        bool& freeze()
+        {
+            return freeze_enabled;
+        }
+
+        bool Frozen() const
+        {
+            return
+                frozen_variant.has_value() &&
+                frozen_ready;
+        }
+
+        bool& compute()
+        {
+            return compute_enabled;
+        }
+
+        bool UsingCompute() const
+        {
+            return compute_enabled && ComputeSupported();
+        }
     };
 }
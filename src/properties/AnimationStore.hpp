@@ -0,0 +1,217 @@
+#pragma once
+
+#include "Easing.hpp"
+#include "../math/Math.hpp"
+
+#include <array>
+#include <vector>
+#include <functional>
+
+#include <glm/gtc/quaternion.hpp>
+
+namespace Properties
+{
+    using Callback = std::function<void()>;
+
+    template<typename T>
+    class Property;
+
+    // Position of a running animation, kept up to date by its store as
+    // other animations are removed around it
+    struct AnimationSlot
+    {
+        size_t lane;
+        size_t index;
+    };
+
+    class IAnimationStore
+    {
+    public:
+        virtual ~IAnimationStore() = default;
+
+        // Callbacks of finished animations are appended to completed, the
+        // manager runs them once every store is consistent again
+        virtual void Update(
+            const float time_step,
+            std::vector<Callback>& completed) = 0;
+
+        virtual size_t Size() const = 0;
+    };
+
+    template<class A> A Interpolate(
+        const A origin,
+        const A target,
+        const float t)
+    {
+        return origin + ((target - origin) * t);
+    }
+
+    inline glm::quat Interpolate(
+        const glm::quat origin,
+        const glm::quat target,
+        const float t)
+    {
+        return glm::slerp(origin, target, t);
+    }
+
+    // Every running animation of one value type, as structure of arrays.
+    // Animations are split into one lane per easing function so easing
+    // runs as a batch per lane. Finished animations are swap-removed.
+    template<typename T>
+    class AnimationStore : public IAnimationStore
+    {
+    private:
+        struct Lane
+        {
+            std::vector<T> start;
+            std::vector<T> end;
+            std::vector<float> time;
+            std::vector<float> duration;
+            std::vector<float> t;
+            std::vector<float> eased;
+            std::vector<Property<T>*> owners;
+            std::vector<Callback> callbacks;
+
+            size_t Size() const
+            {
+                return owners.size();
+            }
+        };
+
+        std::array<Lane, easing_function_count> lanes;
+
+        template<typename V>
+        static void SwapRemove(
+            std::vector<V>& values,
+            const size_t index)
+        {
+            if (index + 1 != values.size())
+            {
+                values[index] = std::move(values.back());
+            }
+
+            values.pop_back();
+        }
+
+    public:
+        void Add(
+            Property<T>& owner,
+            const T start,
+            const T end,
+            const float seconds,
+            const EasingFunction func,
+            Callback callback)
+        {
+            const size_t lane_index = static_cast<size_t>(func);
+            Lane& lane = lanes[lane_index];
+
+            lane.start.push_back(start);
+            lane.end.push_back(end);
+            lane.time.push_back(0.0f);
+            lane.duration.push_back(seconds);
+            lane.t.push_back(0.0f);
+            lane.eased.push_back(0.0f);
+            lane.owners.push_back(&owner);
+            lane.callbacks.push_back(std::move(callback));
+
+            owner.store = this;
+            owner.slot = { lane_index, lane.Size() - 1 };
+        }
+
+        // O(1), the last animation of the lane takes the freed slot
+        void Remove(
+            const AnimationSlot slot)
+        {
+            Lane& lane = lanes[slot.lane];
+            const size_t index = slot.index;
+
+            lane.owners[index]->store = nullptr;
+
+            SwapRemove(lane.start, index);
+            SwapRemove(lane.end, index);
+            SwapRemove(lane.time, index);
+            SwapRemove(lane.duration, index);
+            SwapRemove(lane.t, index);
+            SwapRemove(lane.eased, index);
+            SwapRemove(lane.owners, index);
+            SwapRemove(lane.callbacks, index);
+
+            if (index < lane.Size())
+            {
+                lane.owners[index]->slot.index = index;
+            }
+        }
+
+        void Update(
+            const float time_step,
+            std::vector<Callback>& completed) override
+        {
+            for (size_t l = 0; l < lanes.size(); l++)
+            {
+                Lane& lane = lanes[l];
+                const size_t count = lane.Size();
+
+                if (count == 0)
+                {
+                    continue;
+                }
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    lane.time[i] += time_step;
+                    lane.t[i] = lane.duration[i] > 0.0f ?
+                        std::min(lane.time[i] / lane.duration[i], 1.0f) :
+                        1.0f;
+                }
+
+                Ease(
+                    static_cast<EasingFunction>(l),
+                    lane.t.data(),
+                    lane.eased.data(),
+                    count);
+
+                for (size_t i = 0; i < count; i++)
+                {
+                    lane.owners[i]->Write(
+                        Interpolate(
+                            lane.start[i],
+                            lane.end[i],
+                            lane.eased[i]));
+                }
+
+                // Backwards, so the animation swapped into a freed slot
+                // has already been checked
+                for (size_t i = count; i-- > 0;)
+                {
+                    if (lane.t[i] < 1.0f)
+                    {
+                        continue;
+                    }
+
+                    // Lands exactly on the target whatever the curve does
+                    lane.owners[i]->Write(lane.end[i]);
+
+                    if (lane.callbacks[i] != nullptr)
+                    {
+                        completed.push_back(
+                            std::move(lane.callbacks[i]));
+                    }
+
+                    Remove({ l, i });
+                }
+            }
+        }
+
+        size_t Size() const override
+        {
+            size_t size = 0;
+
+            for (const auto& lane : lanes)
+            {
+                size += lane.Size();
+            }
+
+            return size;
+        }
+    };
+}
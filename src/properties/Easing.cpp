@@ -2,42 +2,139 @@
 
 namespace Properties
 {
+    namespace Curves
+    {
+        inline float Linear(const float t)
+        {
+            return t;
+        }
+
+        inline float EaseInQuad(const float t)
+        {
+            return t * t;
+        }
+
+        inline float EaseOutQuad(const float t)
+        {
+            return t * (2 - t);
+        }
+
+        inline float EaseInOutQuad(const float t)
+        {
+            return t < .5f ? 2 * t * t :
+                -1 + (4 - 2 * t) * t;
+        }
+
+        inline float EaseInCubic(const float t)
+        {
+            return t * t * t;
+        }
+
+        inline float EaseOutCubic(const float t)
+        {
+            const float k = t - 1;
+            return k * k * k + 1;
+        }
+
+        inline float EaseInOutCubic(const float t)
+        {
+            return t < .5f ? 4 * t * t * t :
+                (t - 1) * (2 * t - 2) * (2 * t - 2) + 1;
+        }
+
+        inline float EaseInQuart(const float t)
+        {
+            return t * t * t * t;
+        }
+
+        inline float EaseOutQuart(const float t)
+        {
+            const float k = t - 1;
+            return 1 - k * k * k * k;
+        }
+
+        inline float EaseInOutQuart(const float t)
+        {
+            const float k = t - 1;
+            return t < .5f ? 8 * t * t * t * t :
+                1 - 8 * k * k * k * k;
+        }
+
+        inline float EaseInQuint(const float t)
+        {
+            return t * t * t * t * t;
+        }
+
+        inline float EaseOutQuint(const float t)
+        {
+            const float k = t - 1;
+            return 1 + k * k * k * k * k;
+        }
+
+        inline float EaseInOutQuint(const float t)
+        {
+            const float k = t - 1;
+            return t < .5f ? 16 * t * t * t * t * t :
+                1 + 16 * k * k * k * k * k;
+        }
+    }
+
+    template <typename F>
+    void EaseEach(
+        const float* t,
+        float* eased,
+        const size_t count,
+        F curve)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            eased[i] = curve(t[i]);
+        }
+    }
+
     float Ease(const EasingFunction func, const float t)
     {
-        float k = t - 1;
+        float eased = 0;
+        Ease(func, &t, &eased, 1);
+        return eased;
+    }
+
+    void Ease(
+        const EasingFunction func,
+        const float* t,
+        float* eased,
+        const size_t count)
+    {
         switch (func)
         {
         case EasingFunction::Linear:
-            return t;
+            return EaseEach(t, eased, count, Curves::Linear);
         case EasingFunction::EaseInQuad:
-            return t * t;
+            return EaseEach(t, eased, count, Curves::EaseInQuad);
         case EasingFunction::EaseOutQuad:
-            return t * (2 - t);
+            return EaseEach(t, eased, count, Curves::EaseOutQuad);
         case EasingFunction::EaseInOutQuad:
-            return t < .5 ? 2 * t * t :
-                -1 + (4 - 2 * t) * t;
+            return EaseEach(t, eased, count, Curves::EaseInOutQuad);
         case EasingFunction::EaseInCubic:
-            return t * t * t;
+            return EaseEach(t, eased, count, Curves::EaseInCubic);
         case EasingFunction::EaseOutCubic:
-            return k * k * k + 1;
+            return EaseEach(t, eased, count, Curves::EaseOutCubic);
         case EasingFunction::EaseInOutCubic:
-            return t < .5 ? 4 * t * t * t :
-                (t - 1) * (2 * t - 2) * (2 * t - 2) + 1;
+            return EaseEach(t, eased, count, Curves::EaseInOutCubic);
         case EasingFunction::EaseInQuart:
-            return t * t * t * t;
+            return EaseEach(t, eased, count, Curves::EaseInQuart);
         case EasingFunction::EaseOutQuart:
-            return 1 - k * k * k * k;
+            return EaseEach(t, eased, count, Curves::EaseOutQuart);
         case EasingFunction::EaseInOutQuart:
-            return t < .5 ? 8 * t * t * t * t :
-                1 - 8 * k * k * k * k;
+            return EaseEach(t, eased, count, Curves::EaseInOutQuart);
         case EasingFunction::EaseInQuint:
-            return t * t * t * t * t;
+            return EaseEach(t, eased, count, Curves::EaseInQuint);
         case EasingFunction::EaseOutQuint:
-            return 1 + k * k * k * t * t;
+            return EaseEach(t, eased, count, Curves::EaseOutQuint);
         case EasingFunction::EaseInOutQuint:
-            return t < .5 ? 16 * t * t * t *  t * t :
-                1 + 16 * k * k * k * k * k;
+            return EaseEach(t, eased, count, Curves::EaseInOutQuint);
         }
-        return 0;
+
+        EaseEach(t, eased, count, [](const float) { return 0.0f; });
     }
 }
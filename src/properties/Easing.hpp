@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 namespace Properties
 {
     enum class EasingFunction
@@ -19,5 +21,17 @@ namespace Properties
         EaseInOutQuint
     };
 
+    constexpr size_t easing_function_count =
+        static_cast<size_t>(EasingFunction::EaseInOutQuint) + 1;
+
     float Ease(const EasingFunction func, const float t);
+
+    // eased[i] = Ease(func, t[i]). The function is picked once for the
+    // whole batch, so the loop has no branches the compiler can't turn
+    // into vector selects.
+    void Ease(
+        const EasingFunction func,
+        const float* t,
+        float* eased,
+        const size_t count);
 }
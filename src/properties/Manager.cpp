@@ -2,31 +2,45 @@
 
 namespace Properties
 {
-    void Manager::Add(IProperty* property)
+    size_t Manager::NextTypeIndex()
     {
-        properties.push_back(property);
+        static size_t next_index = 0;
+        return next_index++;
     }
 
     void Manager::Update(const float time_step)
     {
-        std::vector<size_t> removals;
+        std::vector<Callback> completed;
 
-        for (size_t i = 0; i < properties.size(); i++)
+        for (auto& store : stores)
         {
-            IProperty* p = properties[i];
-            if (p->InterpolatorCount() != 0)
+            if (store != nullptr)
             {
-                p->Update(time_step);
-            }
-            else
-            {
-                removals.push_back(i);
+                store->Update(
+                    time_step,
+                    completed);
             }
         }
 
-        for (auto& index : removals)
+        // Callbacks may start or stop animations, so they run last
+        for (auto& callback : completed)
         {
-            properties.erase(properties.begin() + index);
+            callback();
         }
     }
+
+    size_t Manager::AnimationCount() const
+    {
+        size_t count = 0;
+
+        for (const auto& store : stores)
+        {
+            if (store != nullptr)
+            {
+                count += store->Size();
+            }
+        }
+
+        return count;
+    }
 }
@@ -3,20 +3,50 @@
 #include <memory>
 #include <vector>
 
-#include "IProperty.hpp"
+#include "AnimationStore.hpp"
 
 namespace Properties
 {
+    // Owns one AnimationStore per animated value type, so a frame costs
+    // one virtual call per type rather than one per property
     class Manager
     {
     private:
-        std::vector<IProperty*> properties;
+        std::vector<std::unique_ptr<IAnimationStore>> stores;
+
+        static size_t NextTypeIndex();
+
+        template<typename T>
+        static size_t TypeIndex()
+        {
+            static const size_t index = NextTypeIndex();
+            return index;
+        }
 
     public:
         Manager() = default;
         Manager(const Manager&) = delete;
 
-        void Add(IProperty* property);
+        template<typename T>
+        AnimationStore<T>& Store()
+        {
+            const size_t index = TypeIndex<T>();
+
+            if (index >= stores.size())
+            {
+                stores.resize(index + 1);
+            }
+
+            if (stores[index] == nullptr)
+            {
+                stores[index] = std::make_unique<AnimationStore<T>>();
+            }
+
+            return static_cast<AnimationStore<T>&>(*stores[index]);
+        }
+
         void Update(const float time_step);
+
+        size_t AnimationCount() const;
     };
 }
@@ -3,20 +3,44 @@
 #include <memory>
 #include <functional>
 
+#include "../DirtySpan.hpp"
+
 #include "Easing.hpp"
 #include "Manager.hpp"
-#include "IProperty.hpp"
-#include "Interpolator.hpp"
+#include "AnimationStore.hpp"
 
 namespace Properties
 {
+    // A value driven by the Manager's animation stores. One animation runs
+    // at a time, animating again retargets from the given start.
     template<typename T>
-    class Property : public IProperty
+    class Property
     {
     private:
+        friend class AnimationStore<T>;
+
         T value;
 
-        std::vector<Interpolator<T>> interpolators;
+        AnimationStore<T>* store = nullptr;
+        AnimationSlot slot = {};
+
+        T* target = nullptr;
+        DirtySpan* target_span = nullptr;
+
+        void Write(
+            const T next)
+        {
+            value = next;
+
+            if (target != nullptr)
+            {
+                *target = next;
+
+                target_span->Mark(
+                    target,
+                    sizeof(T));
+            }
+        }
 
     public:
         Property() = default;
@@ -28,34 +52,46 @@ namespace Properties
         {
         }
 
+        ~Property()
+        {
+            Stop();
+        }
+
         T Value() const
         {
             return value;
         }
 
-        size_t InterpolatorCount()
+        bool Animating() const
         {
-            return interpolators.size();
+            return store != nullptr;
         }
 
-        void Update(const float time_step)
+        // Animation writes go straight to field as well and mark it in
+        // span, e.g. a member of a GL::UniformBuffer's object and its
+        // Dirty(). The property takes the field's current value.
+        void Bind(
+            T& field,
+            DirtySpan& span)
         {
-            std::vector<size_t> removals;
-
-            for (size_t j = 0; j < interpolators.size(); j++)
-            {
-                auto& i = interpolators[j];
-                value = i.Update(time_step);
+            value = field;
+            target = &field;
+            target_span = &span;
+        }
 
-                if (i.Complete())
-                {
-                    removals.push_back(j);
-                }
-            }
+        void Unbind()
+        {
+            target = nullptr;
+            target_span = nullptr;
+        }
 
-            for (auto& index : removals)
+        // Leaves the value where it is, the callback doesn't run
+        void Stop()
+        {
+            if (store != nullptr)
             {
-                interpolators.erase(interpolators.begin() + index);
+                store->Remove(
+                    slot);
             }
         }
 
@@ -65,17 +101,17 @@ namespace Properties
             const T end,
             const float seconds,
             const EasingFunction func,
-            const Callback callback = []() {})
+            Callback callback = nullptr)
         {
-            if (InterpolatorCount() == 0)
-            {
-                manager.Add(this);
-            }
+            Stop();
 
-            Interpolator<T> it(start, end, seconds, func,
+            manager.Store<T>().Add(
+                *this,
+                start,
+                end,
+                seconds,
+                func,
                 std::move(callback));
-
-            interpolators.push_back(it);
         }
     };
 }
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "../math/Math.hpp"
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+namespace Properties
+{
+    // Keyframed curve of cubic Hermite segments. T needs + and * float,
+    // so floats and glm vectors work. Keys added without a tangent get a
+    // Catmull-Rom one from their neighbours.
+    //
+    // Sampling remembers the segment it last landed in and checks it and
+    // the next one first, so forward playback never binary searches. A
+    // baked track samples a uniform table instead, O(1) for any time.
+    template<typename T>
+    class Track
+    {
+    private:
+        std::vector<float> times;
+        std::vector<T> values;
+        std::vector<T> tangents;
+        std::vector<uint8_t> automatic;
+
+        bool looping = false;
+        bool tangents_dirty = false;
+
+        size_t segment = 0;
+
+        std::vector<T> table;
+        float table_step = 0.0f;
+
+        float Wrap(
+            const float time) const
+        {
+            const float start = times.front();
+            const float duration = times.back() - start;
+
+            if (!looping || duration <= 0.0f)
+            {
+                return std::clamp(time, start, times.back());
+            }
+
+            const float offset = std::fmod(time - start, duration);
+
+            return start + (offset < 0.0f ? offset + duration : offset);
+        }
+
+        void UpdateTangents()
+        {
+            const size_t last = times.size() - 1;
+
+            for (size_t i = 0; i <= last; i++)
+            {
+                if (!automatic[i])
+                {
+                    continue;
+                }
+
+                size_t previous = i > 0 ? i - 1 : i;
+                size_t next = i < last ? i + 1 : i;
+                float span = times[next] - times[previous];
+
+                // Loops expect the last key to repeat the first, the ends
+                // take their slope across the seam
+                if (looping && last >= 2 && (i == 0 || i == last))
+                {
+                    previous = last - 1;
+                    next = 1;
+                    span =
+                        (times[last] - times[last - 1]) +
+                        (times[1] - times[0]);
+                }
+
+                tangents[i] = span > 0.0f ?
+                    (values[next] - values[previous]) * (1.0f / span) :
+                    values[i] * 0.0f;
+            }
+
+            tangents_dirty = false;
+        }
+
+        // Index of the key starting the segment that contains time
+        size_t FindSegment(
+            const float time)
+        {
+            const size_t last_segment = times.size() - 2;
+
+            segment = std::min(segment, last_segment);
+
+            if (time >= times[segment] && time <= times[segment + 1])
+            {
+                return segment;
+            }
+
+            if (segment < last_segment &&
+                time >= times[segment + 1] && time <= times[segment + 2])
+            {
+                return ++segment;
+            }
+
+            // Seeks and loop wraps
+            const auto it = std::upper_bound(
+                times.begin(),
+                times.end(),
+                time);
+
+            const size_t index = static_cast<size_t>(
+                std::max<std::ptrdiff_t>(it - times.begin() - 1, 0));
+
+            segment = std::min(index, last_segment);
+
+            return segment;
+        }
+
+        T Evaluate(
+            const float time)
+        {
+            if (tangents_dirty)
+            {
+                UpdateTangents();
+            }
+
+            const size_t i = FindSegment(time);
+
+            const float t0 = times[i];
+            const float span = times[i + 1] - t0;
+            const float s = span > 0.0f ? (time - t0) / span : 0.0f;
+
+            const float s2 = s * s;
+            const float s3 = s2 * s;
+
+            const float h00 = 2.0f * s3 - 3.0f * s2 + 1.0f;
+            const float h10 = s3 - 2.0f * s2 + s;
+            const float h01 = -2.0f * s3 + 3.0f * s2;
+            const float h11 = s3 - s2;
+
+            return
+                values[i] * h00 +
+                tangents[i] * (h10 * span) +
+                values[i + 1] * h01 +
+                tangents[i + 1] * (h11 * span);
+        }
+
+        void Insert(
+            const float time,
+            const T value,
+            const T tangent,
+            const bool is_automatic)
+        {
+            const size_t index = static_cast<size_t>(
+                std::upper_bound(times.begin(), times.end(), time) -
+                times.begin());
+
+            times.insert(times.begin() + index, time);
+            values.insert(values.begin() + index, value);
+            tangents.insert(tangents.begin() + index, tangent);
+            automatic.insert(automatic.begin() + index, is_automatic);
+
+            tangents_dirty = true;
+            table.clear();
+        }
+
+    public:
+        Track(
+            const bool looping = false) :
+            looping(looping)
+        {
+        }
+
+        void Add(
+            const float time,
+            const T value)
+        {
+            Insert(
+                time,
+                value,
+                value * 0.0f,
+                true);
+        }
+
+        // tangent is the slope in value units per second
+        void Add(
+            const float time,
+            const T value,
+            const T tangent)
+        {
+            Insert(
+                time,
+                value,
+                tangent,
+                false);
+        }
+
+        size_t KeyCount() const
+        {
+            return times.size();
+        }
+
+        float Duration() const
+        {
+            return times.empty() ?
+                0.0f :
+                times.back() - times.front();
+        }
+
+        bool Baked() const
+        {
+            return !table.empty();
+        }
+
+        // Resamples the curve into samples evenly spaced values. Sample
+        // then linearly interpolates the table, adding keys drops it.
+        void Bake(
+            const size_t samples)
+        {
+            if (times.size() < 2 || samples < 2)
+            {
+                throw std::runtime_error(
+                    "Baking a track needs two keys and two samples");
+            }
+
+            table.clear();
+            table.reserve(samples);
+
+            table_step = Duration() / static_cast<float>(samples - 1);
+
+            for (size_t i = 0; i < samples; i++)
+            {
+                const float time = std::min(
+                    times.front() + table_step * static_cast<float>(i),
+                    times.back());
+
+                table.push_back(Evaluate(time));
+            }
+        }
+
+        T Sample(
+            const float time)
+        {
+            if (times.empty())
+            {
+                throw std::runtime_error(
+                    "Sampling a track without keys");
+            }
+
+            if (times.size() == 1)
+            {
+                return values.front();
+            }
+
+            const float wrapped = Wrap(
+                time);
+
+            if (table.empty())
+            {
+                return Evaluate(wrapped);
+            }
+
+            const float position = table_step > 0.0f ?
+                (wrapped - times.front()) / table_step :
+                0.0f;
+
+            const size_t index = std::min(
+                static_cast<size_t>(position),
+                table.size() - 2);
+
+            const float fraction = std::min(
+                position - static_cast<float>(index),
+                1.0f);
+
+            return
+                table[index] +
+                (table[index + 1] - table[index]) * fraction;
+        }
+    };
+}
@@ -0,0 +1,481 @@
+#include "../src/properties/Track.hpp"
+#include "../src/properties/Property.hpp"
+
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+
+// Advances many concurrent animations per frame with Properties::Manager
+// and with the per-object IProperty path it replaced, reporting ms/frame,
+// then samples keyframe tracks the way the day cycle does, reporting
+// samples per second.
+//
+// usage: AnimationBench [--count N]
+// N animations (100000 by default) at 60 frames a second, first all
+// running for the whole run, then with staggered durations until every
+// one has completed. N / 100 looping tracks of day cycle shape are
+// sampled for steady_frames frames each.
+
+namespace Legacy
+{
+    using Properties::Callback;
+    using Properties::EasingFunction;
+
+    class IProperty
+    {
+    public:
+        virtual ~IProperty() = default;
+        virtual void Update(float time_step) = 0;
+        virtual size_t InterpolatorCount() = 0;
+    };
+
+    class Interpolator
+    {
+    private:
+        EasingFunction func;
+        std::optional<Callback> on_complete;
+        float value_0;
+        float value_1;
+        float time = 0;
+        float duration = 0;
+        bool complete = false;
+
+    public:
+        Interpolator(
+            const float origin,
+            const float target,
+            const float duration,
+            const EasingFunction func,
+            const Callback callback) :
+            func(func),
+            value_0(origin),
+            value_1(target),
+            duration(duration)
+        {
+            on_complete = callback;
+        }
+
+        bool Complete() const
+        {
+            return complete;
+        }
+
+        float Update(const float time_step)
+        {
+            time += time_step;
+            float t = Properties::Ease(func, std::min(time / duration, 1.0f));
+
+            if (t >= 1.0f)
+            {
+                complete = true;
+                t = 1.0f;
+
+                if (on_complete.has_value())
+                {
+                    on_complete.value()();
+                }
+            }
+
+            return value_0 + (value_1 - value_0) * t;
+        }
+    };
+
+    // Kept as it was apart from two fixes that let it finish: progress is
+    // clamped, the out curves never reached 1 past the end, and removals
+    // erase in descending order rather than past the end
+    class Manager
+    {
+    private:
+        std::vector<IProperty*> properties;
+
+    public:
+        void Add(IProperty* property)
+        {
+            properties.push_back(property);
+        }
+
+        void Update(const float time_step)
+        {
+            std::vector<size_t> removals;
+
+            for (size_t i = 0; i < properties.size(); i++)
+            {
+                IProperty* p = properties[i];
+                if (p->InterpolatorCount() != 0)
+                {
+                    p->Update(time_step);
+                }
+                else
+                {
+                    removals.push_back(i);
+                }
+            }
+
+            for (size_t i = removals.size(); i-- > 0;)
+            {
+                properties.erase(properties.begin() + removals[i]);
+            }
+        }
+
+        size_t Count() const
+        {
+            return properties.size();
+        }
+    };
+
+    class Property : public IProperty
+    {
+    private:
+        float value = 0.0f;
+        std::vector<Interpolator> interpolators;
+
+    public:
+        float Value() const
+        {
+            return value;
+        }
+
+        size_t InterpolatorCount()
+        {
+            return interpolators.size();
+        }
+
+        void Update(const float time_step)
+        {
+            std::vector<size_t> removals;
+
+            for (size_t j = 0; j < interpolators.size(); j++)
+            {
+                auto& i = interpolators[j];
+                value = i.Update(time_step);
+
+                if (i.Complete())
+                {
+                    removals.push_back(j);
+                }
+            }
+
+            for (size_t i = removals.size(); i-- > 0;)
+            {
+                interpolators.erase(interpolators.begin() + removals[i]);
+            }
+        }
+
+        void Animate(
+            Manager& manager,
+            const float start,
+            const float end,
+            const float seconds,
+            const EasingFunction func,
+            const Callback callback = []() {})
+        {
+            if (InterpolatorCount() == 0)
+            {
+                manager.Add(this);
+            }
+
+            interpolators.emplace_back(
+                start,
+                end,
+                seconds,
+                func,
+                callback);
+        }
+    };
+}
+
+const float frame_step = 1.0f / 60.0f;
+const uint32_t steady_frames = 300;
+
+using Clock = std::chrono::steady_clock;
+
+double Milliseconds(
+    const Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(
+        Clock::now() - start).count();
+}
+
+Properties::EasingFunction Easing(
+    const size_t i)
+{
+    return static_cast<Properties::EasingFunction>(
+        i % Properties::easing_function_count);
+}
+
+// Spread from 0.1 to 2 seconds so completions arrive every frame
+float StaggeredDuration(
+    const size_t i)
+{
+    return 0.1f + static_cast<float>(i % 115) * frame_step;
+}
+
+struct Timing
+{
+    double steady_ms = 0.0;
+    double drain_ms = 0.0;
+    uint32_t drain_frames = 0;
+    size_t completed = 0;
+};
+
+Timing BenchLegacy(
+    const size_t count)
+{
+    Timing timing;
+
+    Legacy::Manager manager;
+    std::vector<Legacy::Property> properties(count);
+
+    const float long_duration = steady_frames * frame_step * 2.0f;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        properties[i].Animate(manager, 0.0f, 1.0f, long_duration, Easing(i));
+    }
+
+    auto start = Clock::now();
+
+    for (uint32_t frame = 0; frame < steady_frames; frame++)
+    {
+        manager.Update(frame_step);
+    }
+
+    timing.steady_ms = Milliseconds(start) / steady_frames;
+
+    Legacy::Manager drain_manager;
+    std::vector<Legacy::Property> drained(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        drained[i].Animate(
+            drain_manager,
+            0.0f,
+            1.0f,
+            StaggeredDuration(i),
+            Easing(i),
+            [&timing]() {
+                timing.completed++;
+            });
+    }
+
+    start = Clock::now();
+
+    // The manager drops a property the frame after it completes
+    while (drain_manager.Count() > 0)
+    {
+        drain_manager.Update(frame_step);
+        timing.drain_frames++;
+    }
+
+    timing.drain_ms = Milliseconds(start);
+
+    return timing;
+}
+
+Timing BenchStore(
+    const size_t count)
+{
+    Timing timing;
+
+    Properties::Manager manager;
+    std::vector<Properties::Property<float>> properties(count);
+
+    const float long_duration = steady_frames * frame_step * 2.0f;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        properties[i].Animate(manager, 0.0f, 1.0f, long_duration, Easing(i));
+    }
+
+    auto start = Clock::now();
+
+    for (uint32_t frame = 0; frame < steady_frames; frame++)
+    {
+        manager.Update(frame_step);
+    }
+
+    timing.steady_ms = Milliseconds(start) / steady_frames;
+
+    for (auto& property : properties)
+    {
+        property.Stop();
+    }
+
+    std::vector<Properties::Property<float>> drained(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        drained[i].Animate(
+            manager,
+            0.0f,
+            1.0f,
+            StaggeredDuration(i),
+            Easing(i),
+            [&timing]() {
+                timing.completed++;
+            });
+    }
+
+    start = Clock::now();
+
+    while (manager.AnimationCount() > 0)
+    {
+        manager.Update(frame_step);
+        timing.drain_frames++;
+    }
+
+    timing.drain_ms = Milliseconds(start);
+
+    return timing;
+}
+
+void Report(
+    const char* name,
+    const Timing& timing)
+{
+    std::cout << name << ": " <<
+        timing.steady_ms << " ms/frame running, " <<
+        timing.drain_ms << " ms to complete all over " <<
+        timing.drain_frames << " frames (" <<
+        timing.completed << " callbacks)" << std::endl;
+}
+
+const size_t track_keys = 9;
+const size_t track_table_size = 256;
+
+// A 60 second loop with keys every 7.5 seconds, like the day cycle
+Properties::Track<float> MakeTrack(
+    const size_t seed)
+{
+    Properties::Track<float> track(true);
+
+    for (size_t k = 0; k < track_keys; k++)
+    {
+        const float value = k + 1 == track_keys ?
+            0.0f :
+            static_cast<float>((seed * 31 + k * 17) % 100) / 100.0f;
+
+        track.Add(static_cast<float>(k) * 7.5f, value);
+    }
+
+    return track;
+}
+
+enum class TrackAccess
+{
+    PLAYBACK,
+    SEEK
+};
+
+double SamplesPerSecond(
+    std::vector<Properties::Track<float>>& tracks,
+    const TrackAccess access)
+{
+    // Playback runs faster than real time so every frame crosses keys
+    const float playback_speed = 60.0f;
+
+    uint32_t random = 12345;
+    float sum = 0.0f;
+
+    const auto start = Clock::now();
+
+    for (uint32_t frame = 0; frame < steady_frames; frame++)
+    {
+        const float time = frame * frame_step * playback_speed;
+
+        for (auto& track : tracks)
+        {
+            random = random * 1664525u + 1013904223u;
+
+            sum += track.Sample(access == TrackAccess::PLAYBACK ?
+                time :
+                static_cast<float>(random >> 8) * (60.0f / 16777216.0f));
+        }
+    }
+
+    const double seconds = Milliseconds(start) / 1000.0;
+
+    // Keeps the samples from being optimised away
+    volatile float sink = sum;
+    (void)sink;
+
+    return static_cast<double>(tracks.size()) * steady_frames / seconds;
+}
+
+void BenchTracks(
+    const size_t count)
+{
+    std::vector<Properties::Track<float>> tracks;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        tracks.push_back(MakeTrack(i));
+    }
+
+    std::cout << count << " tracks of " << track_keys << " keys, " <<
+        steady_frames << " frames" << std::endl;
+
+    std::cout << "Hermite playback: " <<
+        SamplesPerSecond(tracks, TrackAccess::PLAYBACK) / 1e6 <<
+        "M samples/s" << std::endl;
+
+    std::cout << "Hermite random seek: " <<
+        SamplesPerSecond(tracks, TrackAccess::SEEK) / 1e6 <<
+        "M samples/s" << std::endl;
+
+    for (auto& track : tracks)
+    {
+        track.Bake(track_table_size);
+    }
+
+    std::cout << "Baked playback: " <<
+        SamplesPerSecond(tracks, TrackAccess::PLAYBACK) / 1e6 <<
+        "M samples/s" << std::endl;
+
+    std::cout << "Baked random seek: " <<
+        SamplesPerSecond(tracks, TrackAccess::SEEK) / 1e6 <<
+        "M samples/s" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = 100000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+
+        if (argument == "--count" && i + 1 < argc)
+        {
+            count = std::max(std::atoi(argv[++i]), 1);
+        }
+        else
+        {
+            std::cerr << "usage: AnimationBench [--count N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << count << " animations, " <<
+        steady_frames << " frames running" << std::endl;
+
+    const Timing legacy = BenchLegacy(count);
+    const Timing store = BenchStore(count);
+
+    Report("IProperty per object", legacy);
+    Report("AnimationStore lanes", store);
+
+    std::cout << "speedup " <<
+        legacy.steady_ms / store.steady_ms << "x running, " <<
+        legacy.drain_ms / store.drain_ms << "x completing" << std::endl;
+
+    BenchTracks(
+        std::max<size_t>(count / 100, 1));
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include "../src/Hash.hpp"
+#include "../src/Pack.hpp"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBI_WRITE_NO_STDIO
+#include "stb/stb_image_write.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+// Build step for PACK_FILES. Packs every file below the given directories
+// into one archive in the format described in src/Pack.hpp.
+//
+// usage: AssetPack [--store] <output.pack> <directory>...
+// Entry names are paths relative to the working directory, the same paths
+// the application opens. --store disables deflate for every entry.
+
+// Deflate only pays off when it saves at least this fraction
+constexpr size_t min_saving_divisor = 8;
+constexpr int deflate_quality = 8;
+
+std::vector<uint8_t> ReadAll(
+    const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file)
+    {
+        throw std::runtime_error(
+            "Failed to open " + path.generic_string());
+    }
+
+    return std::vector<uint8_t>(
+        std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+}
+
+void Align(
+    std::string& output)
+{
+    const size_t padding =
+        (Pack::blob_alignment - output.size() % Pack::blob_alignment) %
+        Pack::blob_alignment;
+
+    output.append(padding, '\0');
+}
+
+template <typename T>
+void Append(
+    std::string& output,
+    const T& value)
+{
+    output.append(
+        reinterpret_cast<const char*>(&value),
+        sizeof(T));
+}
+
+int main(int argc, char** argv)
+{
+    bool store = false;
+    std::vector<std::string> arguments;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+
+        if (argument == "--store")
+        {
+            store = true;
+        }
+        else
+        {
+            arguments.push_back(argument);
+        }
+    }
+
+    if (arguments.size() < 2)
+    {
+        std::cerr << "usage: AssetPack [--store] <output.pack> <directory>..." << std::endl;
+        return 1;
+    }
+
+    const std::string output_path = arguments[0];
+
+    std::vector<std::string> paths;
+
+    for (size_t i = 1; i < arguments.size(); i++)
+    {
+        std::error_code error;
+
+        for (const auto& entry :
+            std::filesystem::recursive_directory_iterator(arguments[i], error))
+        {
+            if (entry.is_regular_file())
+            {
+                paths.push_back(
+                    entry.path().lexically_normal().generic_string());
+            }
+        }
+
+        if (error)
+        {
+            std::cerr << "AssetPack: can't read " << arguments[i] << std::endl;
+            return 1;
+        }
+    }
+
+    // Sorted so the same inputs always produce the same pack
+    std::sort(paths.begin(), paths.end());
+
+    std::string output(sizeof(Pack::Header), '\0');
+    Align(output);
+
+    std::string names;
+    std::vector<Pack::Entry> entries;
+
+    try
+    {
+        for (const auto& path : paths)
+        {
+            const std::vector<uint8_t> contents = ReadAll(path);
+
+            Pack::Entry entry = {};
+            entry.hash = hash_fnv1a(path);
+            entry.offset = output.size();
+            entry.size = contents.size();
+            entry.stored_size = contents.size();
+            entry.name_offset = static_cast<uint32_t>(names.size());
+            entry.name_length = static_cast<uint32_t>(path.size());
+
+            names += path;
+
+            int deflated_size = 0;
+            unsigned char* deflated = nullptr;
+
+            if (!store && !contents.empty())
+            {
+                deflated = stbi_zlib_compress(
+                    const_cast<unsigned char*>(contents.data()),
+                    static_cast<int>(contents.size()),
+                    &deflated_size,
+                    deflate_quality);
+            }
+
+            const bool use_deflated =
+                deflated != nullptr &&
+                static_cast<size_t>(deflated_size) <
+                    contents.size() - contents.size() / min_saving_divisor;
+
+            if (use_deflated)
+            {
+                entry.flags |= Pack::ENTRY_DEFLATE;
+                entry.stored_size = static_cast<uint64_t>(deflated_size);
+                output.append(
+                    reinterpret_cast<const char*>(deflated),
+                    deflated_size);
+            }
+            else
+            {
+                output.append(
+                    reinterpret_cast<const char*>(contents.data()),
+                    contents.size());
+            }
+
+            STBIW_FREE(deflated);
+
+            Align(output);
+            entries.push_back(entry);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "AssetPack: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::sort(
+        entries.begin(),
+        entries.end(),
+        [](const Pack::Entry& a, const Pack::Entry& b) {
+            return a.hash < b.hash;
+        });
+
+    Pack::Header header = {};
+    header.magic = Pack::pack_magic;
+    header.version = Pack::pack_version;
+    header.entry_count = static_cast<uint32_t>(entries.size());
+    header.names_size = static_cast<uint32_t>(names.size());
+    header.toc_offset = output.size();
+
+    for (const auto& entry : entries)
+    {
+        Append(output, entry);
+    }
+
+    header.names_offset = output.size();
+    output += names;
+
+    std::memcpy(
+        output.data(),
+        &header,
+        sizeof(Pack::Header));
+
+    // Leave the file alone when nothing changed so dependents don't rebuild
+    {
+        std::ifstream existing(output_path, std::ios::binary);
+        std::stringstream existing_contents;
+        existing_contents << existing.rdbuf();
+
+        if (existing && existing_contents.str() == output)
+        {
+            return 0;
+        }
+    }
+
+    std::ofstream file(output_path, std::ios::binary);
+    file << output;
+
+    return file ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+#include "../src/File.hpp"
+#include "../src/gl/Parser.hpp"
+#include "../src/gl/Preprocessor.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+// Build step for EMBED_SHADERS. Expands each shader given on the command
+// line, reflects it with the runtime Parser and writes the source and the
+// reflection out as C++ for GL::EmbeddedShaders.
+//
+// usage: ShaderEmbed <output.cpp> <shader.glsl>...
+// Shader paths are relative to the working directory and are the paths
+// Shader::Load is called with at runtime.
+
+std::string Literal(
+    const std::string_view text)
+{
+    std::stringstream literal;
+    literal << "\"";
+
+    for (const char c : text)
+    {
+        switch (c)
+        {
+        case '\\':
+            literal << "\\\\";
+            break;
+        case '"':
+            literal << "\\\"";
+            break;
+        case '\t':
+            literal << "\\t";
+            break;
+        case '\r':
+            literal << "\\r";
+            break;
+        case '\n':
+            literal << "\\n";
+            break;
+        default:
+            if (c < ' ' || c > '~')
+            {
+                literal << "\\" << std::oct << std::setw(3) << std::setfill('0') <<
+                    static_cast<uint32_t>(static_cast<uint8_t>(c)) << std::dec;
+            }
+            else
+            {
+                literal << c;
+            }
+            break;
+        }
+    }
+
+    literal << "\"";
+    return literal.str();
+}
+
+// One literal per line keeps each piece under compiler string limits
+std::string SourceLiteral(
+    const std::string& source)
+{
+    std::stringstream literal;
+
+    for (size_t begin = 0; begin < source.size();)
+    {
+        size_t end = source.find('\n', begin);
+        end = end == std::string::npos ? source.size() : end + 1;
+
+        literal << "        " << Literal(
+            std::string_view(source).substr(begin, end - begin)) << std::endl;
+
+        begin = end;
+    }
+
+    if (source.empty())
+    {
+        literal << "        \"\"" << std::endl;
+    }
+
+    return literal.str();
+}
+
+std::string Identifier(
+    const std::string& path)
+{
+    std::string identifier;
+
+    for (const char c : path)
+    {
+        const bool alphanumeric =
+            (c >= 'a' && c <= 'z') ||
+            (c >= 'A' && c <= 'Z') ||
+            (c >= '0' && c <= '9');
+
+        identifier += alphanumeric ? c : '_';
+    }
+
+    return identifier;
+}
+
+std::string TypePairs(
+    const std::vector<TypePair>& pairs)
+{
+    std::stringstream table;
+    table << "{";
+
+    for (const auto& pair : pairs)
+    {
+        table << std::endl << "            { " <<
+            Literal(std::get<0>(pair)) << ", " <<
+            Literal(std::get<1>(pair)) << " },";
+    }
+
+    table << (pairs.empty() ? "}" : "\n        }");
+    return table.str();
+}
+
+std::string Blocks(
+    const std::vector<UniformBlock>& blocks)
+{
+    std::stringstream table;
+    table << "{";
+
+    for (const auto& block : blocks)
+    {
+        table << std::endl << "            { " <<
+            Literal(block.type) << ", " <<
+            Literal(block.name) << ", {";
+
+        for (const auto& member : block.members)
+        {
+            table << std::endl << "                { " <<
+                Literal(std::get<0>(member)) << ", " <<
+                Literal(std::get<1>(member)) << " },";
+        }
+
+        table << (block.members.empty() ? "} }," : "\n            } },");
+    }
+
+    table << (blocks.empty() ? "}" : "\n        }");
+    return table.str();
+}
+
+const char* StageName(
+    const ShaderParseType stage)
+{
+    switch (stage)
+    {
+    case ShaderParseType::VERTEX:
+        return "ShaderParseType::VERTEX";
+    case ShaderParseType::FRAGMENT:
+        return "ShaderParseType::FRAGMENT";
+    case ShaderParseType::COMPUTE:
+        return "ShaderParseType::COMPUTE";
+    }
+
+    return "";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: ShaderEmbed <output.cpp> <shader.glsl>..." << std::endl;
+        return 1;
+    }
+
+    const std::string output_path = argv[1];
+
+    std::stringstream output;
+    std::stringstream entries;
+
+    output << "// Generated by tools/ShaderEmbed.cpp, do not edit" << std::endl;
+    output << std::endl;
+    output << "#include \"gl/EmbeddedShaders.hpp\"" << std::endl;
+    output << std::endl;
+    output << "namespace GL" << std::endl;
+    output << "{" << std::endl;
+    output << "namespace EmbeddedShaders" << std::endl;
+    output << "{" << std::endl;
+
+    try
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            const std::string path = argv[i];
+            const std::string name = Identifier(path);
+
+            const std::string source = GL::Preprocessor::Expand(path);
+            const std::vector<std::string> dependencies =
+                GL::Preprocessor::Dependencies(path);
+
+            const Parser parser(source);
+
+            output << "    constexpr std::string_view " << name << "_source =" << std::endl;
+            output << SourceLiteral(source);
+            output << "        ;" << std::endl;
+            output << std::endl;
+
+            if (!dependencies.empty())
+            {
+                output << "    constexpr std::string_view " << name << "_dependencies[] = {" << std::endl;
+                for (const auto& dependency : dependencies)
+                {
+                    output << "        " << Literal(dependency) << "," << std::endl;
+                }
+                output << "    };" << std::endl;
+                output << std::endl;
+            }
+
+            output << "    Parser " << name << "_reflection()" << std::endl;
+            output << "    {" << std::endl;
+            output << "        Parser parser;" << std::endl;
+
+            for (const auto& stage : parser.stages)
+            {
+                output << std::endl;
+                output << "        parser.stages.push_back({ " << StageName(stage.stage) << " });" << std::endl;
+                output << "        parser.stages.back().attributes = " << TypePairs(stage.attributes) << ";" << std::endl;
+                output << "        parser.stages.back().uniform_sampler2Ds = " << TypePairs(stage.uniform_sampler2Ds) << ";" << std::endl;
+                output << "        parser.stages.back().uniform_sampler2D_arrays = " << TypePairs(stage.uniform_sampler2D_arrays) << ";" << std::endl;
+                output << "        parser.stages.back().uniform_image2Ds = " << TypePairs(stage.uniform_image2Ds) << ";" << std::endl;
+                output << "        parser.stages.back().uniform_blocks = " << Blocks(stage.uniform_blocks) << ";" << std::endl;
+                output << "        parser.stages.back().storage_blocks = " << Blocks(stage.storage_blocks) << ";" << std::endl;
+                output << "        parser.stages.back().uniform_mat4s = " << TypePairs(stage.uniform_mat4s) << ";" << std::endl;
+                output << "        parser.stages.back().uniform_floats = " << TypePairs(stage.uniform_floats) << ";" << std::endl;
+            }
+
+            output << std::endl;
+            output << "        return parser;" << std::endl;
+            output << "    }" << std::endl;
+            output << std::endl;
+
+            entries << "        {" << std::endl;
+            entries << "            " << Literal(path) << "," << std::endl;
+            entries << "            " << name << "_source," << std::endl;
+            entries << "            " << (dependencies.empty() ? "nullptr" : name + "_dependencies") << "," << std::endl;
+            entries << "            " << dependencies.size() << "," << std::endl;
+            entries << "            &" << name << "_reflection" << std::endl;
+            entries << "        }," << std::endl;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ShaderEmbed: " << e.what() << std::endl;
+        return 1;
+    }
+
+    output << "    extern const Entry entries[] = {" << std::endl;
+    output << entries.str();
+    output << "    };" << std::endl;
+    output << std::endl;
+    output << "    extern const size_t entry_count = " << (argc - 2) << ";" << std::endl;
+    output << "}" << std::endl;
+    output << "}" << std::endl;
+
+    // Leave the file alone when nothing changed so dependents don't rebuild
+    {
+        std::ifstream existing(output_path, std::ios::binary);
+        std::stringstream existing_contents;
+        existing_contents << existing.rdbuf();
+
+        if (existing && existing_contents.str() == output.str())
+        {
+            return 0;
+        }
+    }
+
+    std::ofstream file(output_path, std::ios::binary);
+    file << output.str();
+
+    return file ? 0 : 1;
+}
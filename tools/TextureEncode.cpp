@@ -0,0 +1,176 @@
+#include "../src/Ktx2.hpp"
+#include "../src/TextureEncoder.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+// Bakes an HDR image, e.g. a sky map saved from Pipelines::Atmosphere,
+// into a KTX2 file with a full mip chain for GL::CompressedTexture.
+//
+// usage: TextureEncode [--bc6h | --rgb9e5] [--fast | --high] [--no-mips]
+//                      <input.hdr> <output.ktx2>
+// BC6H is the default, it needs EXT_texture_compression_bptc at runtime.
+// RGB9E5 is four times larger but samples on every GLES 3 device.
+// Output carries no data format descriptor, it is read by Ktx2::Parse and
+// not by general KTX tools.
+
+int main(int argc, char** argv)
+{
+    bool bc6h = true;
+    bool mipmaps = true;
+    TextureEncoder::Quality quality = TextureEncoder::Quality::NORMAL;
+
+    std::vector<std::string> arguments;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+
+        if (argument == "--bc6h")
+        {
+            bc6h = true;
+        }
+        else if (argument == "--rgb9e5")
+        {
+            bc6h = false;
+        }
+        else if (argument == "--fast")
+        {
+            quality = TextureEncoder::Quality::FAST;
+        }
+        else if (argument == "--high")
+        {
+            quality = TextureEncoder::Quality::HIGH;
+        }
+        else if (argument == "--no-mips")
+        {
+            mipmaps = false;
+        }
+        else
+        {
+            arguments.push_back(argument);
+        }
+    }
+
+    if (arguments.size() != 2)
+    {
+        std::cerr << "usage: TextureEncode [--bc6h | --rgb9e5] [--fast | --high] "
+            "[--no-mips] <input.hdr> <output.ktx2>" << std::endl;
+        return 1;
+    }
+
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+
+    float* raw_data = stbi_loadf(
+        arguments[0].c_str(),
+        &width,
+        &height,
+        &channels,
+        STBI_rgb_alpha);
+
+    if (raw_data == nullptr)
+    {
+        std::cerr << "TextureEncode: can't read " << arguments[0] << std::endl;
+        return 1;
+    }
+
+    std::vector<glm::vec4> texels(
+        static_cast<size_t>(width) * height);
+
+    for (size_t i = 0; i < texels.size(); i++)
+    {
+        texels[i] = glm::vec4(
+            raw_data[i * 4 + 0],
+            raw_data[i * 4 + 1],
+            raw_data[i * 4 + 2],
+            raw_data[i * 4 + 3]);
+    }
+
+    stbi_image_free(
+        raw_data);
+
+    std::vector<std::vector<uint8_t>> levels;
+    Ktx2::Format format = Ktx2::BC6H_UFLOAT_BLOCK;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    try
+    {
+        uint32_t level_width = width;
+        uint32_t level_height = height;
+
+        for (;;)
+        {
+            TextureEncoder::Encoded encoded = bc6h ?
+                TextureEncoder::EncodeBC6H(
+                    texels,
+                    level_width,
+                    level_height,
+                    quality) :
+                TextureEncoder::EncodeRGB9E5(
+                    texels,
+                    level_width,
+                    level_height);
+
+            std::cout << "level " << levels.size() << " " <<
+                level_width << "x" << level_height <<
+                " rmse " << encoded.error.rmse <<
+                " log rmse " << encoded.error.log_rmse <<
+                " max " << encoded.error.max_error << std::endl;
+
+            format = encoded.format;
+            levels.push_back(std::move(encoded.data));
+
+            if (!mipmaps || (level_width == 1 && level_height == 1))
+            {
+                break;
+            }
+
+            texels = TextureEncoder::Downsample(
+                texels,
+                level_width,
+                level_height);
+
+            level_width = std::max(level_width / 2, 1u);
+            level_height = std::max(level_height / 2, 1u);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "TextureEncode: " << e.what() << std::endl;
+        return 1;
+    }
+
+    const std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    const std::string file = Ktx2::Write(
+        format,
+        width,
+        height,
+        levels);
+
+    std::ofstream output(arguments[1], std::ios::binary);
+    output.write(file.data(), file.size());
+
+    if (!output)
+    {
+        std::cerr << "TextureEncode: can't write " << arguments[1] << std::endl;
+        return 1;
+    }
+
+    const size_t source_size = static_cast<size_t>(width) * height * sizeof(glm::vec4);
+
+    std::cout << arguments[1] << ": " << file.size() << " bytes, " <<
+        static_cast<double>(source_size) / file.size() <<
+        "x smaller than the RGBA32F base level, " <<
+        elapsed.count() << " ms" << std::endl;
+
+    return 0;
+}
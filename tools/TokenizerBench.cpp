@@ -0,0 +1,456 @@
+#include "../src/Parsing.hpp"
+
+#include <new>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <filesystem>
+
+// Tokenizes a library of GLSL with the string_view tokenizer and with the
+// allocating one it replaced, reporting MB/s and heap allocations per KB.
+//
+// usage: TokenizerBench [--megabytes N] [shader files...]
+// Shaders default to files/gl/*.glsl, repeated until the library is N MB
+// (8 by default).
+
+static size_t allocations = 0;
+
+void* operator new(
+    size_t size)
+{
+    allocations++;
+
+    void* memory = std::malloc(size > 0 ? size : 1);
+
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(
+    void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(
+    void* memory,
+    size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace Legacy
+{
+    struct Token
+    {
+        std::string type = "";
+        std::string value = "";
+        uint32_t from = 0;
+        uint32_t to = 0;
+    };
+
+    // The tokenizer before TokenArena, with its operator loop appending to
+    // the token rather than the source. Unicode escapes are left out.
+    std::vector<Token> tokenize(std::string str)
+    {
+        const std::string prefix = "<>+-&";
+        const std::string suffix = "=>&:";
+
+        const size_t length = str.size();
+
+        char character = ' ';
+        uint32_t from = 0;
+        uint32_t index = 0;
+        double n_val;
+        char q_val;
+        std::string s_val;
+
+        std::vector<Token> result;
+
+        if (str == "")
+        {
+            return result;
+        }
+
+        str = str + " ";
+
+        character = str.at(index);
+        while (character)
+        {
+            from = index;
+
+            if (character <= ' ')
+            {
+                if (index == length)
+                {
+                    return result;
+                }
+
+                index += 1;
+                character = str.at(index);
+            }
+            else if (
+                (character >= 'a' && character <= 'z') ||
+                (character >= 'A' && character <= 'Z'))
+            {
+                s_val = character;
+                index += 1;
+                for (;;)
+                {
+                    character = str.at(index);
+                    if ((character >= 'a' && character <= 'z') ||
+                        (character >= 'A' && character <= 'Z') ||
+                        (character >= '0' && character <= '9') ||
+                        (character == '_'))
+                    {
+                        s_val += character;
+                        index += 1;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+
+                result.push_back({
+                    "name",
+                    s_val,
+                    from,
+                    index
+                });
+            }
+            else if (character >= '0' && character <= '9')
+            {
+                s_val = character;
+                index += 1;
+
+                for (;;)
+                {
+                    character = str.at(index);
+                    if (character < '0' || character > '9')
+                    {
+                        break;
+                    }
+                    index += 1;
+                    s_val += character;
+                }
+
+                if (character == '.')
+                {
+                    index += 1;
+                    s_val += character;
+                    for (;;)
+                    {
+                        character = str.at(index);
+                        if (character < '0' || character > '9')
+                        {
+                            break;
+                        }
+                        index += 1;
+                        s_val += character;
+                    }
+                }
+
+                if (character == 'e' || character == 'E')
+                {
+                    index += 1;
+                    s_val += character;
+                    character = str.at(index);
+                    if (character == '-' || character == '+')
+                    {
+                        index += 1;
+                        s_val += character;
+                        character = str.at(index);
+                    }
+                    if (character < '0' || character > '9')
+                    {
+                        throw std::runtime_error(
+                            "Bad exponent");
+                    }
+                    do
+                    {
+                        index += 1;
+                        s_val += character;
+                        character = str.at(index);
+                    }
+                    while (character >= '0' && character <= '9');
+                }
+
+                if (character >= 'a' && character <= 'z' && character != 'f')
+                {
+                    throw std::runtime_error(
+                        "Bad number");
+                }
+
+                n_val = std::stof(s_val);
+
+                if (!std::isfinite(n_val))
+                {
+                    throw std::runtime_error(
+                        "Bad Number.");
+                }
+
+                result.push_back({
+                    "number",
+                    s_val,
+                    from,
+                    index
+                });
+            }
+            else if (character == '\'' || character == '"')
+            {
+                s_val = ' ';
+                q_val = character;
+                index += 1;
+                for (;;)
+                {
+                    character = str.at(index);
+                    if (character < ' ')
+                    {
+                        throw std::runtime_error(
+                            "Unterminated string.");
+                    }
+
+                    if (character == q_val)
+                    {
+                        break;
+                    }
+
+                    if (character == '\\')
+                    {
+                        index += 1;
+                        character = str.at(index);
+                    }
+                    s_val += character;
+                    index += 1;
+                }
+                index += 1;
+                result.push_back({
+                    "string",
+                    s_val,
+                    from,
+                    index
+                });
+                character = str.at(index);
+            }
+            else if (character == '/' && str.at(index + 1) == '/')
+            {
+                index += 1;
+                for (;;)
+                {
+                    character = str.at(index);
+                    if (character == '\n' || character == '\r' || !character)
+                    {
+                        break;
+                    }
+                    index += 1;
+                }
+            }
+            else if (prefix.find(character) != std::string::npos)
+            {
+                s_val = character;
+                index += 1;
+                while (true)
+                {
+                    character = str.at(index);
+                    if (index >= length || suffix.find(character) ==
+                        std::string::npos)
+                    {
+                        break;
+                    }
+                    s_val += character;
+                    index += 1;
+                }
+                result.push_back({
+                    "operator",
+                    s_val,
+                    from,
+                    index
+                });
+            }
+            else
+            {
+                index += 1;
+                result.push_back({
+                    "operator",
+                    std::string(&character, 1),
+                    from,
+                    index
+                });
+                character = str.at(index);
+            }
+        }
+        return result;
+    }
+}
+
+struct Result
+{
+    double seconds = 0.0;
+    size_t allocations = 0;
+    size_t tokens = 0;
+};
+
+template<typename F>
+Result Run(
+    const std::vector<std::string>& library,
+    const uint32_t runs,
+    F tokenize_file)
+{
+    Result best;
+
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        const size_t allocations_start = allocations;
+        size_t tokens = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (const auto& source : library)
+        {
+            tokens += tokenize_file(source);
+        }
+
+        const std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+
+        if (run == 0 || elapsed.count() < best.seconds)
+        {
+            best.seconds = elapsed.count();
+            best.allocations = allocations - allocations_start;
+            best.tokens = tokens;
+        }
+    }
+
+    return best;
+}
+
+void Report(
+    const char* name,
+    const Result& result,
+    const size_t bytes)
+{
+    const double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+    const double kilobytes = static_cast<double>(bytes) / 1024.0;
+
+    std::cout << name << ": " <<
+        result.tokens << " tokens, " <<
+        megabytes / result.seconds << " MB/s, " <<
+        result.allocations / kilobytes << " allocations/KB" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    size_t megabytes = 8;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+
+        if (argument == "--megabytes" && i + 1 < argc)
+        {
+            megabytes = std::max(std::atoi(argv[++i]), 1);
+        }
+        else
+        {
+            paths.push_back(argument);
+        }
+    }
+
+    if (paths.empty())
+    {
+        std::error_code error;
+
+        for (const auto& entry : std::filesystem::directory_iterator("files/gl", error))
+        {
+            if (entry.path().extension() == ".glsl")
+            {
+                paths.push_back(entry.path().string());
+            }
+        }
+    }
+
+    std::vector<std::string> shaders;
+    size_t shader_bytes = 0;
+
+    for (const auto& path : paths)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream text;
+        text << file.rdbuf();
+
+        if (!file)
+        {
+            std::cerr << "TokenizerBench: can't read " << path << std::endl;
+            return 1;
+        }
+
+        shaders.push_back(text.str());
+        shader_bytes += shaders.back().size();
+    }
+
+    if (shader_bytes == 0)
+    {
+        std::cerr << "usage: TokenizerBench [--megabytes N] [shader files...]" << std::endl;
+        return 1;
+    }
+
+    // A large shader library, the same files many times over
+    std::vector<std::string> library;
+    size_t bytes = 0;
+
+    while (bytes < megabytes * 1024 * 1024)
+    {
+        for (const auto& shader : shaders)
+        {
+            library.push_back(shader);
+            bytes += shader.size();
+        }
+    }
+
+    const uint32_t runs = 5;
+
+    try
+    {
+        const Result legacy = Run(
+            library,
+            runs,
+            [](const std::string& source) {
+                return Legacy::tokenize(source).size();
+            });
+
+        TokenArena arena;
+
+        const Result arena_result = Run(
+            library,
+            runs,
+            [&](const std::string& source) {
+                return tokenize(source, arena).size();
+            });
+
+        std::cout << library.size() << " shaders, " <<
+            bytes << " bytes, best of " << runs << " runs" << std::endl;
+
+        Report("std::string tokens", legacy, bytes);
+        Report("string_view tokens", arena_result, bytes);
+
+        std::cout << "speedup " << legacy.seconds / arena_result.seconds << "x" << std::endl;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "TokenizerBench: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}